@@ -15,7 +15,7 @@ case class Control(control:ActorRef)
 case class Source(n: Int)
 case class Push(f: Int, h: Int, edge: Edge)
 case class Accept(amt: Int)
-case class Decline(amt: Int)
+case class Decline(amt: Int, h: Int)
 
 case object Print
 case object Start
@@ -42,6 +42,7 @@ class Node(val index: Int) extends Actor {
 
 	var req = 0
 	var res = 0
+	var low = Int.MaxValue			/* lowest neighbour seen since the last relabel. */
 	
 	def min(a:Int, b:Int) : Int = { if (a < b) a else b }
 
@@ -68,8 +69,20 @@ class Node(val index: Int) extends Actor {
 		}
 	}
 
+	/* req is the current arc: the arcs before it have had an answer
+	 * since the last relabel. a neighbour that declined was not below
+	 * us and one that pushed to us was above, so low + 1 is a valid
+	 * height once every arc has had an answer. a neighbour that
+	 * accepted was below us and may still have capacity left, so then
+	 * we only go up one as before.
+	 */
+
 	def relabel : Unit = {
-		h += 1
+		if (low == Int.MaxValue)
+			h += 1
+		else
+			h = low + 1
+		low = Int.MaxValue
 	}
 
 	def discharge: Unit = {
@@ -131,6 +144,7 @@ class Node(val index: Int) extends Actor {
 		if (h > this.h) {
 			e += f.abs
 			edge.f += f
+			low = min(low, h)
 			sender ! Accept(f.abs)
 
 			if (sink || source) control ! Flow(e)
@@ -138,17 +152,19 @@ class Node(val index: Int) extends Actor {
 			if (!sink) next
 
 		} else {
-			sender ! Decline(f.abs)
+			sender ! Decline(f.abs, this.h)
 		}
 	}
 
 	case Accept(amt: Int) => {
+		low = min(low, h)
 		res += 1
 		next
 	}
 
-	case Decline(amt: Int) => {
+	case Decline(amt: Int, h: Int) => {
 		e += amt
+		low = min(low, h)
 		res += 1
 		next
 	}
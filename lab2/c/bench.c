@@ -0,0 +1,273 @@
+#include <fcntl.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "timebase.h"
+
+/* run a solver a number of times on the same input and report the
+ * spread of each phase it prints with phase_report, and of the
+ * whole run, and the most memory a run had resident. the first
+ * runs only warm up the caches and the page cache and are not
+ * counted. every run must print the same f.
+ *
+ */
+
+#define MAXPHASE 16 /* different phase names.		*/
+#define MAXPCT 8    /* percentiles asked for.		*/
+
+#define USAGE "usage: %s [-r runs] [-w warmup] [-p pct,...] input command [arg ...]"
+
+typedef struct phase_t phase_t;
+
+struct phase_t {
+  char name[32];
+  double* x; /* one sample per counted run.	*/
+  int k;     /* samples so far.			*/
+};
+
+static char* progname;
+
+void error(const char* fmt, ...) {
+  va_list ap;
+  char buf[BUFSIZ];
+
+  va_start(ap, fmt);
+  vsprintf(buf, fmt, ap);
+
+  if (progname != NULL) fprintf(stderr, "%s: ", progname);
+
+  fprintf(stderr, "error: %s\n", buf);
+  exit(1);
+}
+
+static void* xmalloc(size_t s) {
+  void* p;
+  p = malloc(s);
+
+  if (p == NULL) error("out of memory: malloc(%zu) failed", s);
+
+  return p;
+}
+
+static char* run(const char* input, char* argv[], double* sec, long* rss) {
+  struct rusage ru;
+  char* out;
+  size_t size;
+  size_t len;
+  ssize_t r;
+  double begin;
+  pid_t pid;
+  int status;
+  int fd[2];
+  int in;
+
+  /* run argv with input on stdin and give back what it wrote on
+   * stdout and stderr together.
+   *
+   */
+
+  if ((in = open(input, O_RDONLY)) < 0) error("cannot open %s", input);
+
+  if (pipe(fd) < 0) error("pipe failed");
+
+  begin = timebase_sec();
+
+  if ((pid = fork()) < 0) error("fork failed");
+
+  if (pid == 0) {
+    dup2(in, 0);
+    dup2(fd[1], 1);
+    dup2(fd[1], 2);
+    close(in);
+    close(fd[0]);
+    close(fd[1]);
+    execvp(argv[0], argv);
+    fprintf(stderr, "cannot run %s\n", argv[0]);
+    _exit(127);
+  }
+
+  close(in);
+  close(fd[1]);
+
+  size = BUFSIZ;
+  len = 0;
+  out = xmalloc(size);
+
+  while ((r = read(fd[0], out + len, size - len - 1)) > 0) {
+    len += r;
+    if (len + 1 == size) {
+      size *= 2;
+      if ((out = realloc(out, size)) == NULL) error("out of memory");
+    }
+  }
+
+  out[len] = 0;
+  close(fd[0]);
+  wait4(pid, &status, 0, &ru);
+
+  *sec = timebase_sec() - begin;
+  *rss = ru.ru_maxrss;
+
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    fputs(out, stderr);
+    error("%s failed", argv[0]);
+  }
+
+  return out;
+}
+
+static phase_t* find(phase_t* phase, int* nphase, const char* name, int runs) {
+  int i;
+
+  for (i = 0; i < *nphase; i += 1)
+    if (strcmp(phase[i].name, name) == 0) return &phase[i];
+
+  if (*nphase == MAXPHASE) error("more than %d phases", MAXPHASE);
+
+  phase = &phase[(*nphase)++];
+  snprintf(phase->name, sizeof phase->name, "%s", name);
+  phase->x = xmalloc(runs * sizeof(double));
+  phase->k = 0;
+
+  return phase;
+}
+
+static int cmp(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+
+  return (x > y) - (x < y);
+}
+
+static double percentile(double* x, int k, double p) {
+  int i;
+
+  /* nearest rank in sorted x. */
+
+  i = (int)ceil(p / 100 * k) - 1;
+
+  return x[i < 0 ? 0 : i];
+}
+
+int main(int argc, char* argv[]) {
+  phase_t phase[MAXPHASE];
+  double pct[MAXPCT];
+  double seen[MAXPHASE]; /* this run, -1 if not printed.	*/
+  double sec;
+  long rss;    /* kB of this run.		*/
+  long maxrss; /* of all counted runs.		*/
+  char name[32];
+  char* out;
+  char* line;
+  char* p;
+  int nphase = 0;
+  int npct = 0;
+  int runs = 10;
+  int warmup = 1;
+  long long f = 0; /* as printed, of any flow width.	*/
+  long long g;
+  int c;
+  int i;
+  int j;
+  int r;
+
+  progname = argv[0];
+
+  /* + stops at the command so its own options are left alone. */
+
+  while ((c = getopt(argc, argv, "+p:r:w:")) != -1) {
+    switch (c) {
+      case 'p':
+        for (p = strtok(optarg, ","); p != NULL; p = strtok(NULL, ",")) {
+          if (npct == MAXPCT) error("at most %d percentiles", MAXPCT);
+          pct[npct++] = atof(p);
+          if (pct[npct - 1] <= 0 || pct[npct - 1] > 100)
+            error("percentile %s is not in (0, 100]", p);
+        }
+        break;
+      case 'r':
+        runs = atoi(optarg);
+        break;
+      case 'w':
+        warmup = atoi(optarg);
+        break;
+      default:
+        error(USAGE, progname);
+    }
+  }
+
+  if (argc - optind < 2 || runs < 1 || warmup < 0) error(USAGE, progname);
+
+  if (npct == 0) {
+    pct[npct++] = 90;
+    pct[npct++] = 99;
+  }
+
+  init_timebase();
+  maxrss = 0;
+
+  for (r = -warmup; r < runs; r += 1) {
+    out = run(argv[optind], &argv[optind + 1], &sec, &rss);
+
+    if (r >= 0 && rss > maxrss) maxrss = rss;
+
+    /* a phase printed more than once in a run is summed and one
+     * that is not printed at all gets no sample.
+     *
+     */
+
+    for (i = 0; i < MAXPHASE; i += 1) seen[i] = -1;
+
+    if (r >= 0) {
+      find(phase, &nphase, "total", runs);
+      seen[0] = sec;
+    }
+
+    for (line = strtok(out, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+      if (sscanf(line, "f = %lld", &g) == 1) {
+        if (r > -warmup && g != f)
+          error("f = %lld in one run and %lld in another", f, g);
+        f = g;
+      } else if (r >= 0 && sscanf(line, "phase %31s = %lf", name, &sec) == 2) {
+        i = find(phase, &nphase, name, runs) - phase;
+        seen[i] = (seen[i] < 0 ? 0 : seen[i]) + sec;
+      }
+    }
+
+    free(out);
+
+    if (r >= 0)
+      for (i = 0; i < nphase; i += 1)
+        if (seen[i] >= 0) phase[i].x[phase[i].k++] = seen[i];
+  }
+
+  printf("f = %lld\n", f);
+  printf("%d runs after %d warm-up, timebase %s (%.3g ns per tick)\n", runs,
+         warmup, timebase_source(), timebase_tick() * 1e9);
+  printf("%-10s %10s %10s", "ms", "min", "median");
+  for (j = 0; j < npct; j += 1) {
+    snprintf(name, sizeof name, "p%g", pct[j]);
+    printf(" %9s", name);
+  }
+  printf(" %10s\n", "max");
+
+  for (i = 0; i < nphase; i += 1) {
+    qsort(phase[i].x, phase[i].k, sizeof(double), cmp);
+    printf("%-10s %10.3f %10.3f", phase[i].name, phase[i].x[0] * 1e3,
+           percentile(phase[i].x, phase[i].k, 50) * 1e3);
+    for (j = 0; j < npct; j += 1)
+      printf(" %9.3f", percentile(phase[i].x, phase[i].k, pct[j]) * 1e3);
+    printf(" %10.3f\n", phase[i].x[phase[i].k - 1] * 1e3);
+    free(phase[i].x);
+  }
+
+  printf("max rss = %ld kB\n", maxrss);
+
+  return 0;
+}
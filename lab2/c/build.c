@@ -0,0 +1,242 @@
+#include "build.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct build_t build_t;
+typedef struct part_t part_t;
+
+struct build_t {
+  const int* x;
+  int n;
+  int m;
+  int nthread;
+  int* off;
+  const int* at; /* 2m prebuilt slots or NULL.		*/
+  int* cnt;   /* arcs of each of the n nodes per thread.	*/
+  long* sum;  /* arcs in the nodes of each thread.		*/
+  fill_t fill;
+  void* arg;
+};
+
+struct part_t {
+  build_t* b;
+  int t;
+  pthread_t thread;
+};
+
+void error(const char* fmt, ...);
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* thread t handles edges [m * t / T, m * (t + 1) / T) and the
+ * nodes [n * t / T, n * (t + 1) / T).
+ *
+ */
+
+#define FIRST(k, t, T) ((int)((long)(k) * (t) / (T)))
+
+#define MINEDGES 4096 /* fewest edges worth a thread of its own. */
+
+static int histograms(int n, int m, int nthread) {
+  long t;
+
+  /* every thread counts the arcs of all n nodes, so with more
+   * than 2m / n threads the counts would take more room and time
+   * than the arcs themselves.
+   *
+   */
+
+  t = 2 * (long)m / (n > 0 ? n : 1);
+
+  if (t > m / MINEDGES) t = m / MINEDGES;
+
+  if (t > nthread) t = nthread;
+
+  return t < 1 ? 1 : t;
+}
+
+static void* count(void* arg) {
+  part_t* p = arg;
+  build_t* b = p->b;
+  int* cnt;
+  int i;
+
+  cnt = b->cnt + (long)p->t * b->n;
+
+  for (i = FIRST(b->m, p->t, b->nthread);
+       i < FIRST(b->m, p->t + 1, b->nthread); i += 1) {
+    cnt[b->x[3 * i]] += 1;
+    cnt[b->x[3 * i + 1]] += 1;
+  }
+
+  return 0;
+}
+
+static void* degree(void* arg) {
+  part_t* p = arg;
+  build_t* b = p->b;
+  long sum;
+  int run;
+  int c;
+  int u;
+  int t;
+
+  /* turn the per-thread counts of a node into the offset of each
+   * thread within the range of the node, and sum the degrees.
+   *
+   */
+
+  sum = 0;
+
+  for (u = FIRST(b->n, p->t, b->nthread);
+       u < FIRST(b->n, p->t + 1, b->nthread); u += 1) {
+    for (run = 0, t = 0; t < b->nthread; t += 1) {
+      c = b->cnt[(long)t * b->n + u];
+      b->cnt[(long)t * b->n + u] = run;
+      run += c;
+    }
+
+    b->off[u + 1] = run;
+    sum += run;
+  }
+
+  b->sum[p->t] = sum;
+
+  return 0;
+}
+
+static void* prefix(void* arg) {
+  part_t* p = arg;
+  build_t* b = p->b;
+  long run;
+  int u;
+  int t;
+
+  for (run = 0, t = 0; t < p->t; t += 1) run += b->sum[t];
+
+  for (u = FIRST(b->n, p->t, b->nthread);
+       u < FIRST(b->n, p->t + 1, b->nthread); u += 1) {
+    run += b->off[u + 1];
+    b->off[u + 1] = run;
+  }
+
+  return 0;
+}
+
+static void* scatter(void* arg) {
+  part_t* p = arg;
+  build_t* b = p->b;
+  int* cnt;
+  int a;
+  int c;
+  int i;
+  int j;
+
+  cnt = b->cnt + (long)p->t * b->n;
+
+  for (i = FIRST(b->m, p->t, b->nthread);
+       i < FIRST(b->m, p->t + 1, b->nthread); i += 1) {
+    a = b->x[3 * i];
+    c = b->x[3 * i + 1];
+    j = b->off[a] + cnt[a]++;
+    b->fill(b->arg, i, j, b->off[c] + cnt[c]++);
+  }
+
+  return 0;
+}
+
+static void* refill(void* arg) {
+  part_t* p = arg;
+  build_t* b = p->b;
+  int i;
+
+  for (i = FIRST(b->m, p->t, b->nthread);
+       i < FIRST(b->m, p->t + 1, b->nthread); i += 1)
+    b->fill(b->arg, i, b->at[2 * i], b->at[2 * i + 1]);
+
+  return 0;
+}
+
+static void run(part_t* p, int nthread, void* (*f)(void*)) {
+  int i;
+
+  for (i = 1; i < nthread; i += 1)
+    if (pthread_create(&p[i].thread, NULL, f, &p[i]) != 0)
+      error("pthread_create failed");
+
+  f(&p[0]);
+
+  for (i = 1; i < nthread; i += 1)
+    if (pthread_join(p[i].thread, NULL) != 0) error("pthread_join failed");
+}
+
+double build_csr(const int* x, int n, int m, int nthread, int* off,
+                 fill_t fill, void* arg) {
+  build_t b;
+  part_t p[nthread];
+  double begin;
+  int i;
+
+  begin = now();
+
+  b.x = x;
+  b.n = n;
+  b.m = m;
+  b.nthread = histograms(n, m, nthread);
+  b.off = off;
+  b.fill = fill;
+  b.arg = arg;
+  b.cnt = calloc((size_t)b.nthread * n, sizeof(int));
+  b.sum = calloc(b.nthread, sizeof(long));
+
+  if (b.cnt == NULL || b.sum == NULL) error("out of memory: build_csr");
+
+  for (i = 0; i < nthread; i += 1) {
+    p[i].b = &b;
+    p[i].t = i;
+  }
+
+  off[0] = 0;
+
+  run(p, b.nthread, count);
+  run(p, b.nthread, degree);
+  run(p, b.nthread, prefix);
+  run(p, b.nthread, scatter);
+
+  free(b.cnt);
+  free(b.sum);
+
+  return now() - begin;
+}
+
+double build_from(const int* at, int m, int nthread, fill_t fill, void* arg) {
+  build_t b;
+  part_t p[nthread];
+  double begin;
+  int i;
+
+  begin = now();
+  b.m = m;
+  b.nthread = nthread;
+  b.at = at;
+  b.fill = fill;
+  b.arg = arg;
+
+  for (i = 0; i < nthread; i += 1) {
+    p[i].b = &b;
+    p[i].t = i;
+  }
+
+  run(p, nthread, refill);
+
+  return now() - begin;
+}
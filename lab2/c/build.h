@@ -0,0 +1,31 @@
+#ifndef BUILD_H
+#define BUILD_H
+
+/* lays out the two arcs of each of the m edges in x (triples of
+ * node, node, capacity) as one range per node, off[u] up to but
+ * not including off[u + 1], using up to nthread threads. each
+ * thread keeps a count for every node, so no more are used than
+ * there are arcs per node, nor than the edges are worth.
+ *
+ * for edge i, fill(arg, i, j, k) is called with j the slot of the
+ * arc in the range of its first node and k that in the range of
+ * its second. the slots are the same as a sequential pass over
+ * the edges would give, whatever the number of threads.
+ *
+ * returns the seconds it took.
+ *
+ */
+
+typedef void (*fill_t)(void* arg, int i, int j, int k);
+
+double build_csr(const int* x, int n, int m, int nthread, int* off,
+                 fill_t fill, void* arg);
+
+/* the same from slots at[2i] and at[2i + 1] that were built before
+ * and saved with the graph, so only fill is called.
+ *
+ */
+
+double build_from(const int* at, int m, int nthread, fill_t fill, void* arg);
+
+#endif /* BUILD_H */
@@ -0,0 +1,249 @@
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "build.h"
+#include "graphfile.h"
+#include "input.h"
+
+/* convert a graph on stdin to the binary format on stdout. the
+ * input can be the text of the railway lab, a DIMACS max-flow
+ * problem or already binary, for example to add or drop the
+ * prebuilt adjacency.
+ *
+ */
+
+static char* progname;
+
+void error(const char* fmt, ...) {
+  va_list ap;
+  char buf[BUFSIZ];
+
+  va_start(ap, fmt);
+  vsprintf(buf, fmt, ap);
+
+  if (progname != NULL) fprintf(stderr, "%s: ", progname);
+
+  fprintf(stderr, "error: %s\n", buf);
+  exit(1);
+}
+
+static void* xmalloc(size_t s) {
+  void* p;
+  p = malloc(s);
+
+  if (p == NULL) error("out of memory: malloc(%zu) failed", s);
+
+  return p;
+}
+
+static int is_dimacs(input_t* in) {
+  size_t i;
+
+  /* a binary graph starts with "preflow\n", which would pass for
+   * a DIMACS problem line below. DIMACS starts with a comment or
+   * the problem line.
+   *
+   */
+
+  if (in->size >= 8 && memcmp(in->buf, GRAPH_MAGIC, 8) == 0) return 0;
+
+  for (i = 0; i < in->size && (in->buf[i] == ' ' || in->buf[i] == '\n'); i += 1)
+    ;
+
+  return i < in->size && (in->buf[i] == 'c' || in->buf[i] == 'p');
+}
+
+static void swap(int* a, int i, int j) {
+  int x;
+
+  x = a[i];
+  a[i] = a[j];
+  a[j] = x;
+}
+
+static void load_dimacs(graphfile_t* gf, input_t* in) {
+  char line[256];
+  char* p;
+  char* end;
+  char* nl;
+  int* map; /* DIMACS node minus one to ours.	*/
+  int* inv;
+  int* x;
+  char w;
+  long a;
+  long b;
+  long c;
+  int s;
+  int t;
+  int k;
+  int i;
+
+  /* the arcs are directed and nodes go from 1 to n, with s and t
+   * given on n lines. they are renumbered so that s is 0 and t
+   * is n - 1 as the solvers expect.
+   *
+   */
+
+  x = NULL;
+  s = t = -1;
+  k = 0;
+  gf->n = gf->m = -1;
+
+  for (p = in->buf, end = in->buf + in->size; p < end; p = nl + 1) {
+    nl = memchr(p, '\n', end - p);
+
+    if (nl == NULL) nl = end;
+
+    if (nl - p >= (long)sizeof line) error("too long line in DIMACS input");
+
+    memcpy(line, p, nl - p);
+    line[nl - p] = 0;
+
+    switch (line[0]) {
+      case 'p':
+        if (sscanf(line, "p max %d %d", &gf->n, &gf->m) != 2 || gf->n < 2 ||
+            gf->m < 0)
+          error("bad DIMACS problem line: %s", line);
+
+        x = xmalloc(3 * (size_t)gf->m * sizeof(int));
+        break;
+
+      case 'n':
+        if (sscanf(line, "n %ld %c", &a, &w) != 2 || a < 1 || a > gf->n)
+          error("bad DIMACS node line: %s", line);
+
+        if (w == 's')
+          s = a - 1;
+        else if (w == 't')
+          t = a - 1;
+        else
+          error("DIMACS node is neither s nor t");
+        break;
+
+      case 'a':
+        if (x == NULL) error("DIMACS arc before the problem line");
+
+        if (sscanf(line, "a %ld %ld %ld", &a, &b, &c) != 3 || a < 1 ||
+            a > gf->n || b < 1 || b > gf->n || c < 0 || c > INT_MAX)
+          error("bad DIMACS arc line: %s", line);
+
+        if (k == gf->m) error("more than %d DIMACS arcs", gf->m);
+
+        x[3 * k] = a - 1;
+        x[3 * k + 1] = b - 1;
+        x[3 * k + 2] = c;
+        k += 1;
+        break;
+    }
+  }
+
+  if (x == NULL) error("no DIMACS problem line");
+
+  if (s < 0 || t < 0 || s == t) error("DIMACS source and sink missing");
+
+  if (k != gf->m) error("expected %d DIMACS arcs, found %d", gf->m, k);
+
+  map = xmalloc(gf->n * sizeof(int));
+  inv = xmalloc(gf->n * sizeof(int));
+
+  for (i = 0; i < gf->n; i += 1) inv[i] = i;
+
+  /* inv is from ours to DIMACS. after s has been swapped into
+   * place, t is where it was unless it was node 0.
+   *
+   */
+
+  swap(inv, 0, s);
+  swap(inv, gf->n - 1, t == 0 ? s : t);
+
+  for (i = 0; i < gf->n; i += 1) map[inv[i]] = i;
+
+  for (i = 0; i < 3 * gf->m; i += 3) {
+    x[i] = map[x[i]];
+    x[i + 1] = map[x[i + 1]];
+  }
+
+  free(map);
+  free(inv);
+
+  gf->c = 0;
+  gf->p = 0;
+  gf->flags = GRAPH_DIRECTED;
+  gf->x = gf->own = x;
+  gf->route = NULL;
+  gf->off = NULL;
+  gf->at = NULL;
+  gf->binary = 0;
+}
+
+static void fill(void* arg, int i, int j, int k) {
+  int* at = arg;
+
+  at[2 * i] = j;
+  at[2 * i + 1] = k;
+}
+
+int main(int argc, char* argv[]) {
+  graphfile_t gf;
+  input_t in;
+  int* off;
+  int* at;
+  int adjacency = 0;
+  int nthread = 1;
+  int c;
+
+  progname = argv[0];
+
+  while ((c = getopt(argc, argv, "at:")) != -1) {
+    switch (c) {
+      case 'a':
+        /* also store the arc layout so it need not be built. */
+        adjacency = 1;
+        break;
+      case 't':
+        nthread = atoi(optarg);
+        break;
+      default:
+        error("usage: %s [-a] [-t threads] < input > output", progname);
+    }
+  }
+
+  if (nthread < 1) error("need at least one thread");
+
+  if (isatty(fileno(stdout))) error("will not write binary to a terminal");
+
+  input_open(&in, stdin);
+
+  if (is_dimacs(&in))
+    load_dimacs(&gf, &in);
+  else
+    graphfile_load(&gf, &in, nthread);
+
+  off = at = NULL;
+
+  if (adjacency) {
+    off = xmalloc((gf.n + 1) * sizeof(int));
+    at = xmalloc(2 * (size_t)gf.m * sizeof(int));
+    build_csr(gf.x, gf.n, gf.m, nthread, off, fill, at);
+  }
+
+  gf.off = off;
+  gf.at = at;
+
+  graphfile_write(&gf, stdout);
+
+  fprintf(stderr, "n = %d, m = %d, %s%s\n", gf.n, gf.m,
+          gf.flags & GRAPH_DIRECTED ? "directed" : "undirected",
+          adjacency ? ", with adjacency" : "");
+
+  free(off);
+  free(at);
+  graphfile_free(&gf);
+  input_close(&in);
+
+  return 0;
+}
@@ -0,0 +1,20 @@
+#include "counter.h"
+
+static const char* name[COUNTERS] = {"discharge", "scan",  "push", "saturate",
+                                     "relabel",   "round", "steal", "lock",
+                                     "contend",   "cas"};
+
+void counters_add(counters_t* sum, const counters_t* k) {
+  int i;
+
+  for (i = 0; i < COUNTERS; i += 1) sum->n[i] += k->n[i];
+}
+
+void counters_report(FILE* f, const counters_t* k) {
+  int i;
+
+  if (!COUNT) return;
+
+  for (i = 0; i < COUNTERS; i += 1)
+    fprintf(f, "count %s = %ld\n", name[i], k->n[i]);
+}
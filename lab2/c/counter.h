@@ -0,0 +1,54 @@
+#ifndef COUNTER_H
+#define COUNTER_H
+
+#include <stdio.h>
+
+/* counters of what the solvers do, compiled in with -DCOUNT=1
+ * (make count). each thread adds to its own counters_t, which
+ * fills whole cache lines so that no two threads write the same
+ * line, and they are summed when the solver is done. without
+ * COUNT the count macro only uses k, so that it can be the body
+ * of an if and k can be the only use of a parameter.
+ *
+ */
+
+#ifndef COUNT
+#define COUNT 0
+#endif
+
+enum {
+  C_DISCHARGE, /* nodes selected.			*/
+  C_SCAN,      /* arcs looked at.			*/
+  C_PUSH,      /* pushes.				*/
+  C_SATURATE,  /* pushes that used the whole arc.	*/
+  C_RELABEL,   /* relabels.				*/
+  C_ROUND,     /* rounds of lab3.			*/
+  C_STEAL,     /* nodes taken from another worker.	*/
+  C_LOCK,      /* mutexes taken.			*/
+  C_CONTEND,   /* of those, not free at once.	*/
+  C_CAS,       /* failed compare and swaps.		*/
+  COUNTERS
+};
+
+typedef struct counters_t counters_t;
+
+struct counters_t {
+  _Alignas(64) long n[COUNTERS];
+};
+
+#if COUNT
+#define count(k, i) ((k)->n[i] += 1)
+#else
+#define count(k, i) ((void)(k))
+#endif
+
+void counters_add(counters_t* sum, const counters_t* k);
+
+/* print "count name = n" for each counter on f, or nothing
+ * without COUNT.
+ *
+ */
+
+void counters_report(FILE* f, const counters_t* k);
+
+#endif /* COUNTER_H */
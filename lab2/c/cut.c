@@ -0,0 +1,71 @@
+#include "cut.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+void error(const char* fmt, ...);
+
+/* the binary format is little endian whatever the host is. */
+
+static int big_endian() {
+  const uint32_t one = 1;
+
+  return *(const unsigned char*)&one == 0;
+}
+
+static uint32_t swap32(uint32_t x) {
+  return x >> 24 | (x >> 8 & 0xff00) | (x << 8 & 0xff0000) | x << 24;
+}
+
+static void write_ints(FILE* fp, const int* x, int n) {
+  uint32_t buf[1024];
+  int i;
+  int j;
+
+  if (!big_endian()) {
+    fwrite(x, sizeof(int), n, fp);
+    return;
+  }
+
+  for (i = 0; i < n; i += j) {
+    for (j = 0; j < 1024 && i + j < n; j += 1) buf[j] = swap32(x[i + j]);
+
+    fwrite(buf, sizeof(uint32_t), j, fp);
+  }
+}
+
+void cut_write(FILE* fp, int binary, int64_t f, int n, const int* edge, int k,
+               const int* node, int s) {
+  cut_header_t h;
+  int i;
+
+  if (binary) {
+    memset(&h, 0, sizeof h);
+    memcpy(h.magic, CUT_MAGIC, 8);
+    h.version = CUT_VERSION;
+    h.n = n;
+    h.k = k;
+    h.s = s;
+    h.f = f;
+
+    if (big_endian()) {
+      h.version = swap32(h.version);
+      h.n = swap32(h.n);
+      h.k = swap32(h.k);
+      h.s = swap32(h.s);
+      h.f = (int64_t)((uint64_t)swap32(f) << 32 | swap32((uint64_t)f >> 32));
+    }
+
+    fwrite(&h, sizeof h, 1, fp);
+    write_ints(fp, edge, k);
+    write_ints(fp, node, s);
+  } else {
+    fprintf(fp, "%" PRId64 " %d %d\n", f, k, s);
+
+    for (i = 0; i < k; i += 1) fprintf(fp, "%d\n", edge[i]);
+
+    for (i = 0; i < s; i += 1) fprintf(fp, "%d\n", node[i]);
+  }
+
+  if (fflush(fp) != 0 || ferror(fp)) error("writing cut failed");
+}
@@ -0,0 +1,45 @@
+#ifndef CUT_H
+#define CUT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* a minimum cut as preflow -c writes it, either as text:
+ *
+ *	f k s		the flow, cut edges and source side nodes.
+ *	k lines		index of a cut edge in the input.
+ *	s lines		a node of the source side.
+ *
+ * or in binary (with -b), which on a little endian host can be
+ * read by mapping the file:
+ *
+ *	header		32 bytes, see below.
+ *	edges		k ints.
+ *	nodes		s ints.
+ *
+ * all ints are 32 bits, except f with 64, and little endian on
+ * any host. edges and nodes are in increasing order. an edge is
+ * in the cut when it can carry flow from the source side to the
+ * other, and these edges are all saturated and their capacities
+ * add up to f.
+ *
+ */
+
+#define CUT_MAGIC "prefcut\n"
+#define CUT_VERSION 1
+
+typedef struct cut_header_t cut_header_t;
+
+struct cut_header_t {
+  char magic[8];    /* CUT_MAGIC.			*/
+  uint32_t version; /* CUT_VERSION.			*/
+  int32_t n;        /* nodes in the graph.		*/
+  int32_t k;        /* cut edges.			*/
+  int32_t s;        /* source side nodes.		*/
+  int64_t f;        /* maximum flow.			*/
+};
+
+void cut_write(FILE* fp, int binary, int64_t f, int n, const int* edge, int k,
+               const int* node, int s);
+
+#endif /* CUT_H */
@@ -0,0 +1,41 @@
+#include "flow.h"
+
+void error(const char* fmt, ...);
+
+void flow_check(const graphfile_t* gf) {
+  const int* x;
+  int64_t out; /* capacity out of s.		*/
+  int64_t both;
+  int64_t max; /* of both over all edges.	*/
+  int i;
+
+  out = 0;
+  max = 0;
+
+  for (i = 0; i < gf->m; i += 1) {
+    x = gf->x + 3 * i;
+
+    if (x[2] < 0) error("edge %d has capacity %d", i, x[2]);
+
+    both = gf->flags & GRAPH_DIRECTED ? x[2] : 2 * (int64_t)x[2];
+
+    if (both > max) max = both;
+
+    /* an edge from s to s carries nothing. */
+
+    if (x[0] == x[1]) continue;
+
+    if (x[0] == 0 || (x[1] == 0 && !(gf->flags & GRAPH_DIRECTED)))
+      out += x[2];
+  }
+
+  if (out < max) out = max;
+
+  if (out > FLOW_MAX)
+    error("flows up to %" PRId64 " do not fit in %d bits, build with "
+          "FLOW_BITS=%d", out, FLOW_BITS, out > INT32_MAX ? 64 : 32);
+}
+
+void flow_report(FILE* f, size_t bytes) {
+  fprintf(f, "graph = %zu bytes with %d bit flows\n", bytes, FLOW_BITS);
+}
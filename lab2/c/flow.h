@@ -0,0 +1,50 @@
+#ifndef FLOW_H
+#define FLOW_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "graphfile.h"
+
+/* the type of capacities, flows and excess in the solvers, chosen
+ * when they are built with -DFLOW_BITS=16, 32 or 64 (make widths
+ * compares the three). narrower flows make the nodes and edges
+ * smaller, and wider ones are needed when more than 2^31 - 1 can
+ * leave s. heights and indices stay int.
+ *
+ */
+
+#ifndef FLOW_BITS
+#define FLOW_BITS 32
+#endif
+
+#if FLOW_BITS == 16
+typedef int16_t flow_t;
+#define FLOW_MAX INT16_MAX
+#define PRIflow PRId16
+#elif FLOW_BITS == 32
+typedef int32_t flow_t;
+#define FLOW_MAX INT32_MAX
+#define PRIflow PRId32
+#elif FLOW_BITS == 64
+typedef int64_t flow_t;
+#define FLOW_MAX INT64_MAX
+#define PRIflow PRId64
+#else
+#error "FLOW_BITS must be 16, 32 or 64"
+#endif
+
+/* exit with an error naming the width to build with if some flow
+ * in gf may not fit in a flow_t. no excess can be more than the
+ * capacity out of s, and no residual capacity more than that of
+ * an edge in both directions.
+ *
+ */
+
+void flow_check(const graphfile_t* gf);
+
+/* print how many bytes the nodes and edges of a solver take. */
+
+void flow_report(FILE* f, size_t bytes);
+
+#endif /* FLOW_H */
@@ -1,7 +1,9 @@
 #include <assert.h>
 #include <ctype.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -31,8 +33,8 @@ typedef struct xedge_t xedge_t;
 typedef struct graph_t graph_t;
 typedef struct node_t node_t;
 typedef struct edge_t edge_t;
-typedef struct list_t list_t;
 typedef struct work_args work_args;
+typedef struct shard_t shard_t;
 
 struct xedge_t {
   int32_t u; /* one of the two nodes.	*/
@@ -40,19 +42,32 @@ struct xedge_t {
   int32_t c; /* capacity.			*/
 };
 
-struct work_args {
-  graph_t* g;
+/* nodes with excess are kept on a stack of each thread, linked by
+ * next, and the older half is moved at once to a shard when the
+ * stack holds 2 * LOCAL, or sooner when some thread is idle. a
+ * thread with an empty stack takes the whole of one shard, its
+ * own first. this is the container of preflow.c.
+ *
+ */
+
+#define LOCAL 32
+
+struct shard_t {
+  _Alignas(64) _Atomic(node_t*) head;
 };
 
-struct list_t {
-  edge_t* edge;
-  list_t* next;
+struct work_args {
+  graph_t* g;
+  int i;         /* thread index.			*/
+  node_t* local; /* stack of nodes with excess.	*/
+  int size;      /* nodes on it.			*/
 };
 
 struct node_t {
   int h;        /* height.			*/
   int e;        /* excess flow.			*/
-  list_t* edge; /* adjacency list.		*/
+  edge_t** edge; /* adjacency array.		*/
+  int deg;       /* edges in it.			*/
   node_t* next; /* with excess preflow.		*/
   pthread_mutex_t mutex;
 };
@@ -69,10 +84,14 @@ struct graph_t {
   int m;          /* edges.			*/
   node_t* v;      /* array of n nodes.		*/
   edge_t* e;      /* array of m edges.		*/
+  edge_t** adj;   /* 2m, each node's edges together. */
+  int maxn;       /* room in v.			*/
+  int maxm;       /* room in e, and 2 * maxm in adj. */
   node_t* s;      /* source.			*/
   node_t* t;      /* sink.			*/
-  node_t* excess; /* nodes with e > 0 except s,t.	*/
-  pthread_mutex_t mutex;
+  shard_t* shard; /* one per thread.		*/
+  int nshard;
+  atomic_int busy; /* threads with excess nodes.	*/
 };
 
 static char* progname;
@@ -120,43 +139,106 @@ static void* xcalloc(size_t n, size_t s) {
   return p;
 }
 
-static void add_edge(node_t* u, edge_t* e) {
-  list_t* p;
-  p = xmalloc(sizeof(list_t));
-  p->edge = e;
-  p->next = u->edge;
-  u->edge = p;
+static void give(graph_t* g, int j, node_t* first, node_t* last) {
+  _Atomic(node_t*)* head;
+
+  /* put the chain from first to last on shard j. */
+
+  head = &g->shard[j].head;
+  last->next = atomic_load(head);
+
+  while (!atomic_compare_exchange_weak(head, &last->next, first))
+    ;
 }
 
-static void connect(node_t* u, node_t* v, int c, edge_t* e) {
-  /* connect two nodes by putting a shared (same object)
-   * in their adjacency lists.
-   *
-   */
+static void enter_excess(graph_t* g, node_t* v, work_args* w) {
+  node_t* last;
+  int keep;
+  int i;
+
+  if (v == g->t || v == g->s) return;
+
+  v->next = w->local;
+  w->local = v;
+  w->size += 1;
+
+  /* also share when some thread has nothing to do. */
+
+  if (w->size < 2 * LOCAL &&
+      (w->size < 2 || atomic_load_explicit(&g->busy, memory_order_relaxed) ==
+                          g->nshard))
+    return;
 
-  e->u = u;
-  e->v = v;
-  e->c = c;
+  /* give the older half away so the newest stay here. */
 
-  add_edge(u, e);
-  add_edge(v, e);
+  keep = w->size / 2;
+
+  for (last = w->local, i = 1; i < keep; i += 1) last = last->next;
+
+  for (v = last->next; v->next != NULL; v = v->next)
+    ;
+
+  give(g, w->i, last->next, v);
+  last->next = NULL;
+  w->size = keep;
 }
 
-static void enter_excess(graph_t* g, node_t* v) {
-  pthread_mutex_lock(&g->mutex);
-  if (v != g->t && v != g->s) {  // && v != g->s
-    v->next = g->excess;
-    g->excess = v;
+static node_t* take(graph_t* g, work_args* w) {
+  node_t* v;
+  int j;
+  int n;
+
+  /* empty the first shard that is not, from this thread's own. */
+
+  for (j = 0; j < g->nshard; j += 1) {
+    if (atomic_load(&g->shard[(w->i + j) % g->nshard].head) == NULL) continue;
+
+    v = atomic_exchange(&g->shard[(w->i + j) % g->nshard].head, NULL);
+
+    if (v == NULL) continue;
+
+    for (n = 1, w->local = v; v->next != NULL; v = v->next) n += 1;
+
+    w->size = n;
+
+    return w->local;
   }
-  pthread_mutex_unlock(&g->mutex);
+
+  return NULL;
 }
 
-static node_t* leave_excess(graph_t* g) {
+static node_t* leave_excess(graph_t* g, work_args* w) {
   node_t* v;
-  pthread_mutex_lock(&g->mutex);
-  v = g->excess;
-  if (v != NULL) g->excess = v->next;
-  pthread_mutex_unlock(&g->mutex);
+  int idle;
+
+  if (w->local == NULL && take(g, w) == NULL) {
+    /* wait until a shard has nodes or no thread is busy. only a
+     * busy thread can give a node excess, and a thread counts as
+     * busy while it takes nodes, so when none is busy and the
+     * shards are empty there is nothing left to do.
+     *
+     */
+
+    atomic_fetch_sub(&g->busy, 1);
+
+    for (;;) {
+      idle = atomic_load(&g->busy) == 0;
+      atomic_fetch_add(&g->busy, 1);
+
+      if (take(g, w) != NULL) break;
+
+      atomic_fetch_sub(&g->busy, 1);
+
+      if (idle) return NULL;
+
+      sched_yield();
+    }
+  }
+
+  v = w->local;
+  w->local = v->next;
+  w->size -= 1;
+
   return v;
 }
 
@@ -186,20 +268,18 @@ static void* work(void* arg) {
 
   node_t* nei;
   edge_t* edg;
-  list_t* adj;
   int dir;
   int ava;
   int flo;
+  int i;
 
-  graph_t* g = ((work_args*)arg)->g;
+  work_args* w = arg;
+  graph_t* g = w->g;
 
-  node_t* excess = leave_excess(g);
+  node_t* excess = leave_excess(g, w);
   while (excess != NULL) {
-    adj = excess->edge;
-
-    while (adj != NULL) {
-      edg = adj->edge;
-      adj = adj->next;
+    for (i = 0; i < excess->deg; i += 1) {
+      edg = excess->edge[i];
 
       // Get direction and other node
       nei = other(excess, edg);
@@ -226,7 +306,7 @@ static void* work(void* arg) {
       edg->f += dir * flo;
 
       if (nei->e == flo) {
-        enter_excess(g, nei);
+        enter_excess(g, nei, w);
       }
 
       pthread_mutex_unlock(&nei->mutex);
@@ -237,7 +317,7 @@ static void* work(void* arg) {
 
     if (excess->e == 0) {
       pthread_mutex_unlock(&excess->mutex);
-      excess = leave_excess(g);
+      excess = leave_excess(g, w);
     } else {
       pthread_mutex_unlock(&excess->mutex);
     }
@@ -249,34 +329,47 @@ static void* work(void* arg) {
 }
 
 static int xpreflow(graph_t* g, int nthread) {
+  pthread_t thread[nthread];
+  work_args args[nthread];
   node_t* src;
   node_t* nei;
   edge_t* edg;
-  list_t* adj;
   int dir;
   int i;
+  int j;
+
+  for (i = 0; i < nthread; i += 1) {
+    args[i].g = g;
+    args[i].i = i;
+    args[i].local = NULL;
+    args[i].size = 0;
+  }
+
+  atomic_init(&g->busy, nthread);
 
   src = g->s;
   src->h = g->n;
 
-  adj = src->edge;
-
-  // Initial push from source
-  while (adj != NULL) {
-    edg = adj->edge;
-    adj = adj->next;
+  // Initial push from source, dealt to the threads in turn
+  for (i = j = 0; i < src->deg; i += 1) {
+    edg = src->edge[i];
     nei = other(src, edg);
     dir = direction(src, edg);
     edg->f += dir * edg->c;
     nei->e += edg->c;
-    enter_excess(g, nei);
-  }
 
-  pthread_t thread[nthread];
-  work_args arg = {g};
+    /* a node with more than one edge from s already has a
+     * place after the first, and putting it on a stack again
+     * would make the stack a cycle.
+     *
+     */
+
+    if (edg->c > 0 && nei->e == edg->c)
+      enter_excess(g, nei, &args[j++ % nthread]);
+  }
 
   for (i = 0; i < nthread; i += 1)
-    if (pthread_create(&thread[i], NULL, work, &arg) != 0)
+    if (pthread_create(&thread[i], NULL, work, &args[i]) != 0)
       error("pthread_create failed");
 
   for (i = 0; i < nthread; i += 1)
@@ -287,55 +380,39 @@ static int xpreflow(graph_t* g, int nthread) {
 
 static void free_graph(graph_t* g) {
   int i;
-  list_t* p;
-  list_t* q;
-
-  for (i = 0; i < g->n; i += 1) {
-    p = g->v[i].edge;
-    while (p != NULL) {
-      q = p->next;
-      free(p);
-      p = q;
-    }
 
-    pthread_mutex_destroy(&g->v[i].mutex);
-  }
+  for (i = 0; i < g->maxn; i += 1) pthread_mutex_destroy(&g->v[i].mutex);
 
-  pthread_mutex_destroy(&g->mutex);
+  free(g->shard);
   free(g->v);
   free(g->e);
+  free(g->adj);
   free(g);
 }
 
-static graph_t* new_graph(int n, int m, int s, int t, xedge_t* e) {
+static graph_t* new_graph(int n, int m, int nthread) {
   graph_t* g;
   int i;
-  node_t* u;
-  node_t* v;
-  int a;
-  int b;
-  int c;
+
+  /* room for graphs with up to n nodes and m edges. the mutexes
+   * are made once here and not for every graph.
+   *
+   */
 
   g = xcalloc(1, sizeof(graph_t));
-  g->n = n;
-  g->m = m;
+  g->maxn = n;
+  g->maxm = m;
 
   g->v = xcalloc(n, sizeof(node_t));
   g->e = xcalloc(m, sizeof(edge_t));
+  g->adj = xmalloc(2 * (size_t)m * sizeof(edge_t*));
 
-  g->s = &g->v[s];
-  g->t = &g->v[t];
+  g->shard = aligned_alloc(64, nthread * sizeof(shard_t));
+  g->nshard = nthread;
 
-  for (i = 0; i < m; i += 1) {
-    a = e[i].u;
-    b = e[i].v;
-    c = e[i].c;
-    u = &g->v[a];
-    v = &g->v[b];
-    connect(u, v, c, g->e + i);
-  }
+  if (g->shard == NULL) error("out of memory: aligned_alloc failed");
 
-  pthread_mutex_init(&g->mutex, NULL);
+  for (i = 0; i < nthread; i += 1) atomic_init(&g->shard[i].head, NULL);
 
   for (i = 0; i < n; i += 1) {
     pthread_mutex_init(&g->v[i].mutex, NULL);
@@ -344,12 +421,73 @@ static graph_t* new_graph(int n, int m, int s, int t, xedge_t* e) {
   return g;
 }
 
+static void load_graph(graph_t* g, int n, int m, int s, int t, xedge_t* e) {
+  edge_t** p;
+  node_t* u;
+  node_t* v;
+  int i;
+
+  g->n = n;
+  g->m = m;
+  g->s = &g->v[s];
+  g->t = &g->v[t];
+
+  /* count the edges of each node, give each its range of adj and
+   * fill the ranges in, with deg counting again.
+   *
+   */
+
+  for (i = 0; i < n; i += 1) {
+    g->v[i].h = 0;
+    g->v[i].e = 0;
+    g->v[i].deg = 0;
+  }
+
+  for (i = 0; i < m; i += 1) {
+    g->v[e[i].u].deg += 1;
+    g->v[e[i].v].deg += 1;
+  }
+
+  for (p = g->adj, i = 0; i < n; i += 1) {
+    g->v[i].edge = p;
+    p += g->v[i].deg;
+    g->v[i].deg = 0;
+  }
+
+  for (i = 0; i < m; i += 1) {
+    u = &g->v[e[i].u];
+    v = &g->v[e[i].v];
+    g->e[i].u = u;
+    g->e[i].v = v;
+    g->e[i].f = 0;
+    g->e[i].c = e[i].c;
+    u->edge[u->deg++] = &g->e[i];
+    v->edge[v->deg++] = &g->e[i];
+  }
+}
+
+/* the entry point that forsete calls, once per graph. the graph
+ * is kept between calls and only made again when one has more
+ * nodes or edges than any before it, so calls with graphs of about
+ * the same size allocate nothing.
+ *
+ */
+
 int preflow(int n, int m, int s, int t, xedge_t* e) {
-  graph_t* g;
-  int f;
+  static graph_t* g;
+  int maxn;
+  int maxm;
+
+  if (g == NULL || n > g->maxn || m > g->maxm) {
+    maxn = g == NULL || n > g->maxn ? n : g->maxn;
+    maxm = g == NULL || m > g->maxm ? m : g->maxm;
+
+    if (g != NULL) free_graph(g);
+
+    g = new_graph(maxn, maxm, 80);
+  }
+
+  load_graph(g, n, m, s, t, e);
 
-  g = new_graph(n, m, s, t, e);
-  f = xpreflow(g, 80);
-  free_graph(g);
-  return f;
+  return xpreflow(g, 80);
 }
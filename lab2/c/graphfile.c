@@ -0,0 +1,284 @@
+#include "graphfile.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+void error(const char* fmt, ...);
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the binary format is little endian whatever the host is. on a
+ * little endian host the ints are used where they are, and on a
+ * big endian one they are swapped into a copy.
+ *
+ */
+
+static int big_endian() {
+  const uint32_t one = 1;
+
+  return *(const unsigned char*)&one == 0;
+}
+
+static uint32_t swap32(uint32_t x) {
+  return x >> 24 | (x >> 8 & 0xff00) | (x << 8 & 0xff0000) | x << 24;
+}
+
+static uint64_t swap64(uint64_t x) {
+  return (uint64_t)swap32(x) << 32 | swap32(x >> 32);
+}
+
+static void swap_header(graphfile_header_t* h) {
+  int i;
+
+  h->version = swap32(h->version);
+  h->flags = swap32(h->flags);
+  h->n = swap32(h->n);
+  h->m = swap32(h->m);
+  h->c = swap32(h->c);
+  h->p = swap32(h->p);
+
+  for (i = 0; i < 4; i += 1) h->sum[i] = swap64(h->sum[i]);
+}
+
+static void write_ints(FILE* fp, const int* x, size_t n) {
+  uint32_t buf[1024];
+  size_t i;
+  size_t j;
+
+  if (!big_endian()) {
+    fwrite(x, sizeof(int), n, fp);
+    return;
+  }
+
+  for (i = 0; i < n; i += j) {
+    for (j = 0; j < 1024 && i + j < n; j += 1) buf[j] = swap32(x[i + j]);
+
+    fwrite(buf, sizeof(uint32_t), j, fp);
+  }
+}
+
+static uint64_t checksum(const int* p, size_t n) {
+  uint64_t h;
+  size_t i;
+
+  /* 64 bit fnv-1a over whole ints instead of bytes. */
+
+  h = 14695981039346656037ULL;
+
+  for (i = 0; i < n; i += 1) h = (h ^ (uint32_t)p[i]) * 1099511628211ULL;
+
+  return h;
+}
+
+static void check_binary(graphfile_t* gf) {
+  unsigned char* seen;
+  size_t i;
+  int u;
+  int j;
+  int k;
+
+  /* the checksums only catch damage, so also check everything
+   * that is later used as an index before anything is built.
+   *
+   */
+
+  for (i = 0; i < 3 * (size_t)gf->m; i += 3)
+    if (gf->x[i] < 0 || gf->x[i] >= gf->n || gf->x[i + 1] < 0 ||
+        gf->x[i + 1] >= gf->n)
+      error("graph file edge %zu has a node out of range", i / 3);
+
+  for (i = 0; i < (size_t)gf->p; i += 1)
+    if (gf->route[i] < 0 || gf->route[i] >= gf->m)
+      error("graph file route %zu is not an edge", i);
+
+  if (gf->off == NULL) return;
+
+  if (gf->off[0] != 0 || gf->off[gf->n] != 2 * gf->m)
+    error("graph file arc offsets do not cover the 2m arcs");
+
+  for (u = 0; u < gf->n; u += 1)
+    if (gf->off[u] > gf->off[u + 1])
+      error("graph file arc offsets of node %d decrease", u);
+
+  /* each arc must be in a slot of its own node and no two in the
+   * same slot, or some slot would be left unset.
+   *
+   */
+
+  seen = calloc(((size_t)2 * gf->m + 7) / 8, 1);
+
+  if (seen == NULL) error("out of memory: graphfile_load");
+
+  for (i = 0; i < 2 * (size_t)gf->m; i += 1) {
+    u = gf->x[3 * (i / 2) + i % 2];
+    k = gf->at[i];
+
+    if (k < gf->off[u] || k >= gf->off[u + 1])
+      error("graph file arc %zu is not in a slot of node %d", i, u);
+
+    j = k % 8;
+
+    if (seen[k / 8] & (1 << j))
+      error("graph file arc slot %d is used twice", k);
+
+    seen[k / 8] |= 1 << j;
+  }
+
+  free(seen);
+}
+
+static void load_binary(graphfile_t* gf, input_t* in) {
+  graphfile_header_t* h;
+  graphfile_header_t copy;
+  const int* p;
+  size_t size;
+  size_t i;
+  double begin;
+
+  begin = now();
+  h = (graphfile_header_t*)in->buf;
+
+  if (big_endian()) {
+    copy = *h;
+    swap_header(&copy);
+    h = &copy;
+  }
+
+  if (h->version != GRAPH_VERSION)
+    error("graph file version %u, expected %d", h->version, GRAPH_VERSION);
+
+  if ((h->flags & ~(GRAPH_DIRECTED | GRAPH_ADJACENCY)) != 0)
+    error("unknown graph file flags %#x", h->flags);
+
+  if (h->n < 2 || h->m < 0 || h->p < 0) error("bad graph file header");
+
+  size = 3 * (size_t)h->m + h->p;
+
+  if (h->flags & GRAPH_ADJACENCY) size += h->n + 1 + 2 * (size_t)h->m;
+
+  if (in->size != sizeof(graphfile_header_t) + size * sizeof(int))
+    error("graph file is %zu bytes, expected %zu", in->size,
+          sizeof(graphfile_header_t) + size * sizeof(int));
+
+  gf->n = h->n;
+  gf->m = h->m;
+  gf->c = h->c;
+  gf->p = h->p;
+  gf->flags = h->flags;
+  gf->own = NULL;
+  gf->binary = 1;
+
+  p = (const int*)(in->buf + sizeof(graphfile_header_t));
+
+  if (big_endian()) {
+    gf->own = malloc(size * sizeof(int));
+
+    if (gf->own == NULL) error("out of memory: graphfile_load");
+
+    for (i = 0; i < size; i += 1) gf->own[i] = swap32(p[i]);
+
+    p = gf->own;
+  }
+
+  gf->x = p;
+  gf->route = p += 3 * (size_t)gf->m;
+  gf->off = NULL;
+  gf->at = NULL;
+
+  if (gf->flags & GRAPH_ADJACENCY) {
+    gf->off = p += gf->p;
+    gf->at = p += gf->n + 1;
+  }
+
+  if (checksum(gf->x, 3 * (size_t)gf->m) != h->sum[0] ||
+      checksum(gf->route, gf->p) != h->sum[1] ||
+      (gf->off != NULL && (checksum(gf->off, gf->n + 1) != h->sum[2] ||
+                           checksum(gf->at, 2 * (size_t)gf->m) != h->sum[3])))
+    error("graph file checksum mismatch");
+
+  check_binary(gf);
+
+  in->pos = in->size;
+  in->seconds += now() - begin;
+}
+
+static void load_text(graphfile_t* gf, input_t* in, int nthread) {
+  size_t m3;
+
+  gf->n = input_int(in);
+  gf->m = input_int(in);
+  gf->c = input_int(in);
+  gf->p = input_int(in);
+  gf->flags = 0;
+  gf->binary = 0;
+
+  m3 = 3 * (size_t)gf->m;
+  gf->own = malloc((m3 + gf->p) * sizeof(int));
+
+  if (gf->own == NULL) error("out of memory: graphfile_load");
+
+  if (input_ints_parallel(in, gf->own, m3, nthread) != m3)
+    error("expected %d edges", gf->m);
+
+  /* the solvers never needed the routes so tolerate them missing. */
+
+  gf->p = input_ints(in, gf->own + m3, gf->p);
+  gf->x = gf->own;
+  gf->route = gf->own + m3;
+  gf->off = NULL;
+  gf->at = NULL;
+}
+
+void graphfile_load(graphfile_t* gf, input_t* in, int nthread) {
+  if (in->size >= sizeof(graphfile_header_t) &&
+      memcmp(in->buf, GRAPH_MAGIC, 8) == 0)
+    load_binary(gf, in);
+  else
+    load_text(gf, in, nthread);
+}
+
+void graphfile_free(graphfile_t* gf) {
+  free(gf->own);
+  gf->own = NULL;
+}
+
+void graphfile_write(graphfile_t* gf, FILE* fp) {
+  graphfile_header_t h;
+
+  memset(&h, 0, sizeof h);
+  memcpy(h.magic, GRAPH_MAGIC, 8);
+  h.version = GRAPH_VERSION;
+  h.flags = gf->flags & GRAPH_DIRECTED;
+  h.n = gf->n;
+  h.m = gf->m;
+  h.c = gf->c;
+  h.p = gf->p;
+  h.sum[0] = checksum(gf->x, 3 * (size_t)gf->m);
+  h.sum[1] = checksum(gf->route, gf->p);
+
+  if (gf->off != NULL) {
+    h.flags |= GRAPH_ADJACENCY;
+    h.sum[2] = checksum(gf->off, gf->n + 1);
+    h.sum[3] = checksum(gf->at, 2 * (size_t)gf->m);
+  }
+
+  if (big_endian()) swap_header(&h);
+
+  fwrite(&h, sizeof h, 1, fp);
+  write_ints(fp, gf->x, 3 * (size_t)gf->m);
+  write_ints(fp, gf->route, gf->p);
+
+  if (gf->off != NULL) {
+    write_ints(fp, gf->off, gf->n + 1);
+    write_ints(fp, gf->at, 2 * (size_t)gf->m);
+  }
+
+  if (fflush(fp) != 0 || ferror(fp)) error("writing graph file failed");
+}
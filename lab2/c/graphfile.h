@@ -0,0 +1,78 @@
+#ifndef GRAPHFILE_H
+#define GRAPHFILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "input.h"
+
+/* a graph is either the text of the 6railwayplanning lab in EDAF05
+ * (n m C P, m lines a b c, then P route indices) or a binary file
+ * that a little endian host can use straight from the mapping:
+ *
+ *	header		64 bytes, see below.
+ *	edges		3m ints: node, node, capacity.
+ *	routes		P ints.
+ *	off		n + 1 ints, only with GRAPH_ADJACENCY.
+ *	at		2m ints, only with GRAPH_ADJACENCY.
+ *
+ * all ints are 32 bits little endian on any host, and a big
+ * endian host reads them into a copy. off and at are what
+ * build_csr gives: the arcs of node u are in slots off[u] up to
+ * off[u + 1] and edge i has its arcs in slots at[2i] and at[2i + 1].
+ *
+ * nodes are 0 to n - 1 with s = 0 and t = n - 1. without
+ * GRAPH_DIRECTED an edge has capacity c in both directions, and
+ * with it only from its first node to its second.
+ *
+ */
+
+#define GRAPH_MAGIC "preflow\n"
+#define GRAPH_VERSION 1
+
+#define GRAPH_DIRECTED 1  /* edges are arcs.			*/
+#define GRAPH_ADJACENCY 2 /* off and at follow the routes.	*/
+
+typedef struct graphfile_header_t graphfile_header_t;
+typedef struct graphfile_t graphfile_t;
+
+struct graphfile_header_t {
+  char magic[8];    /* GRAPH_MAGIC.			*/
+  uint32_t version; /* GRAPH_VERSION.			*/
+  uint32_t flags;   /* GRAPH_DIRECTED, GRAPH_ADJACENCY.	*/
+  int32_t n;        /* nodes.			*/
+  int32_t m;        /* edges.			*/
+  int32_t c;        /* C and P from the text header.	*/
+  int32_t p;
+  uint64_t sum[4]; /* checksums of the four sections.	*/
+};
+
+struct graphfile_t {
+  int n;
+  int m;
+  int c;
+  int p;
+  int flags;
+  const int* x;     /* 3m: node, node, capacity.	*/
+  const int* route; /* p route indices.		*/
+  const int* off;   /* n + 1 or NULL.		*/
+  const int* at;    /* 2m or NULL.			*/
+  int* own;         /* parsed or swapped, else NULL.	*/
+  int binary;       /* read from a binary file.	*/
+};
+
+/* read the graph from in, which must stay open while gf is used.
+ * a binary file is checked against its sizes and checksums and
+ * only copied on a big endian host, and text is parsed with
+ * nthread threads.
+ *
+ */
+
+void graphfile_load(graphfile_t* gf, input_t* in, int nthread);
+void graphfile_free(graphfile_t* gf);
+
+/* write gf in the binary format. */
+
+void graphfile_write(graphfile_t* gf, FILE* fp);
+
+#endif /* GRAPHFILE_H */
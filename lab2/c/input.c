@@ -0,0 +1,411 @@
+#include "input.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define BLOCK (1 << 20) /* bytes per read when not mapped.	*/
+
+#define MIN(a, b) (((a) <= (b)) ? (a) : (b))
+#define MAX(a, b) (((a) >= (b)) ? (a) : (b))
+
+void error(const char* fmt, ...);
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void input_open(input_t* in, FILE* fp) {
+  struct stat st;
+  size_t size;
+  ssize_t k;
+  double begin;
+  int fd;
+
+  begin = now();
+  fd = fileno(fp);
+
+  in->pos = 0;
+  in->mapped = 0;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    in->size = st.st_size;
+    in->buf = mmap(NULL, in->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (in->buf != MAP_FAILED) {
+      madvise(in->buf, in->size, MADV_SEQUENTIAL);
+      in->mapped = 1;
+      in->seconds = now() - begin;
+      return;
+    }
+  }
+
+  /* a pipe or terminal: read everything in large blocks. */
+
+  size = BLOCK;
+  in->size = 0;
+  in->buf = malloc(size);
+
+  for (;;) {
+    if (in->buf == NULL) error("out of memory: input buffer");
+
+    k = read(fd, in->buf + in->size, size - in->size);
+
+    if (k < 0) error("read failed");
+
+    if (k == 0) break;
+
+    in->size += k;
+
+    if (in->size == size) {
+      size *= 2;
+      in->buf = realloc(in->buf, size);
+    }
+  }
+
+  in->seconds = now() - begin;
+}
+
+void input_close(input_t* in) {
+  if (in->mapped)
+    munmap(in->buf, in->size);
+  else
+    free(in->buf);
+
+  in->buf = NULL;
+}
+
+static int scalar_int(input_t* in) {
+  const char* p;
+  const char* end;
+  int x;
+
+  p = in->buf + in->pos;
+  end = in->buf + in->size;
+
+  while (p < end && (unsigned)(*p - '0') > 9) p += 1;
+
+  for (x = 0; p < end && (unsigned)(*p - '0') <= 9; p += 1)
+    x = 10 * x + *p - '0';
+
+  in->pos = p - in->buf;
+
+  return x;
+}
+
+#ifdef __SSE2__
+
+#ifndef __AVX2__
+
+/* bit i is set when byte i of the 16 at p is a digit. */
+
+static uint64_t digits16(const char* p) {
+  __m128i c;
+  __m128i lt;
+  __m128i gt;
+
+  c = _mm_loadu_si128((const __m128i*)p);
+  lt = _mm_cmplt_epi8(c, _mm_set1_epi8('0'));
+  gt = _mm_cmpgt_epi8(c, _mm_set1_epi8('9'));
+
+  return ~_mm_movemask_epi8(_mm_or_si128(lt, gt)) & 0xffff;
+}
+
+#endif
+
+/* the same for the 64 bytes at p. */
+
+static uint64_t digits64(const char* p) {
+#ifdef __AVX2__
+  __m256i c;
+  __m256i lt;
+  __m256i gt;
+  uint64_t lo;
+  uint64_t hi;
+
+  c = _mm256_loadu_si256((const __m256i*)p);
+  lt = _mm256_cmpgt_epi8(_mm256_set1_epi8('0'), c);
+  gt = _mm256_cmpgt_epi8(c, _mm256_set1_epi8('9'));
+  lo = (uint32_t)~_mm256_movemask_epi8(_mm256_or_si256(lt, gt));
+
+  c = _mm256_loadu_si256((const __m256i*)(p + 32));
+  lt = _mm256_cmpgt_epi8(_mm256_set1_epi8('0'), c);
+  gt = _mm256_cmpgt_epi8(c, _mm256_set1_epi8('9'));
+  hi = (uint32_t)~_mm256_movemask_epi8(_mm256_or_si256(lt, gt));
+
+  return lo | hi << 32;
+#else
+  return digits16(p) | digits16(p + 16) << 16 | digits16(p + 32) << 32 |
+         digits16(p + 48) << 48;
+#endif
+}
+
+/* the value of the len <= 8 digits at p, combining pairs, then
+ * quads, then the two halves of a 64 bit word.
+ *
+ */
+
+static int swar(const char* p, int len) {
+  uint64_t v;
+
+  memcpy(&v, p, 8);
+  v = (v & 0x0f0f0f0f0f0f0f0f) << (8 * (8 - len));
+  v = (v * 2561) >> 8;
+  v = ((v & 0x00ff00ff00ff00ff) * 6553601) >> 16;
+  v = ((v & 0x0000ffff0000ffff) * 42949672960001) >> 32;
+
+  return v;
+}
+
+/* decode as many integers as possible from 64 byte windows. every
+ * integer that lies inside the window is found from the digit mask
+ * and decoded with swar(). one that touches the end of the window
+ * starts the next window, and longer ones go to scalar_int().
+ *
+ */
+
+static size_t vector_ints(input_t* in, int* x, size_t count) {
+  const char* p;
+  const char* end;
+  uint64_t mask;
+  uint64_t run;
+  size_t i;
+  int s;
+  int len;
+
+  p = in->buf + in->pos;
+  end = in->buf + in->size;
+  i = 0;
+
+  /* swar() may read 8 bytes from the last digit of a window. */
+
+  while (i < count && p + 80 <= end) {
+    mask = digits64(p);
+
+    while (i < count) {
+      if (mask == 0) {
+        p += 64;
+        break;
+      }
+
+      s = __builtin_ctzll(mask);
+      run = ~(mask >> s);
+      len = run != 0 ? __builtin_ctzll(run) : 64;
+
+      if (len > 8) {
+        in->pos = p + s - in->buf;
+        x[i++] = scalar_int(in);
+        p = in->buf + in->pos;
+        break;
+      }
+
+      if (s + len >= 64) {
+        p += s;
+        break;
+      }
+
+      x[i++] = swar(p + s, len);
+      mask &= ~0ull << (s + len);
+
+      if (i == count) p += s + len;
+    }
+  }
+
+  in->pos = p - in->buf;
+
+  return i;
+}
+
+#endif
+
+int input_int(input_t* in) { return scalar_int(in); }
+
+static size_t decode(input_t* in, int* x, size_t count) {
+  size_t i;
+
+  i = 0;
+
+#ifdef __SSE2__
+  i = vector_ints(in, x, count);
+#endif
+
+  for (; i < count; i += 1) {
+    while (in->pos < in->size && (unsigned)(in->buf[in->pos] - '0') > 9)
+      in->pos += 1;
+
+    if (in->pos == in->size) break;
+
+    x[i] = scalar_int(in);
+  }
+
+  return i;
+}
+
+size_t input_ints(input_t* in, int* x, size_t count) {
+  double begin;
+  size_t i;
+
+  begin = now();
+  i = decode(in, x, count);
+  in->seconds += now() - begin;
+
+  return i;
+}
+
+/* number of integers in the bytes from p up to end, given that
+ * the byte before p is not a digit.
+ *
+ */
+
+static size_t count_ints(const char* p, const char* end) {
+#ifdef __SSE2__
+  uint64_t mask;
+#endif
+  uint64_t prev;
+  size_t n;
+  int d;
+
+  n = 0;
+  prev = 0;
+
+#ifdef __SSE2__
+  for (; p + 64 <= end; p += 64) {
+    mask = digits64(p);
+    n += __builtin_popcountll(mask & ~(mask << 1 | prev));
+    prev = mask >> 63;
+  }
+#endif
+
+  for (; p < end; p += 1) {
+    d = (unsigned)(*p - '0') <= 9;
+    n += d && !prev;
+    prev = d;
+  }
+
+  return n;
+}
+
+typedef struct chunk_t chunk_t;
+
+struct chunk_t {
+  input_t view;    /* the bytes of this chunk.	*/
+  int* x;          /* where its first integer goes.	*/
+  size_t n;        /* integers in the chunk.		*/
+  size_t want;     /* of those, how many to decode.	*/
+  pthread_t thread;
+};
+
+static void* count_chunk(void* arg) {
+  chunk_t* c = arg;
+
+  c->n = count_ints(c->view.buf, c->view.buf + c->view.size);
+
+  return 0;
+}
+
+static void* decode_chunk(void* arg) {
+  chunk_t* c = arg;
+
+  decode(&c->view, c->x, c->want);
+
+  return 0;
+}
+
+static void run(chunk_t* c, int nchunk, void* (*f)(void*)) {
+  int i;
+
+  for (i = 1; i < nchunk; i += 1)
+    if (pthread_create(&c[i].thread, NULL, f, &c[i]) != 0)
+      error("pthread_create failed");
+
+  f(&c[0]);
+
+  for (i = 1; i < nchunk; i += 1)
+    if (pthread_join(c[i].thread, NULL) != 0) error("pthread_join failed");
+}
+
+size_t input_ints_parallel(input_t* in, int* x, size_t count, int nthread) {
+  chunk_t c[nthread];
+  const char* p;
+  const char* end;
+  size_t first;
+  size_t len;
+  double begin;
+  int i;
+
+  if (nthread <= 1 || in->size - in->pos < (size_t)nthread * BLOCK)
+    return input_ints(in, x, count);
+
+  begin = now();
+
+  /* cut the rest of the input in nthread pieces that start on a
+   * new line, count the integers of every piece in parallel and
+   * then let each thread decode its piece to the right place.
+   *
+   */
+
+  p = in->buf + in->pos;
+  end = in->buf + in->size;
+  len = (end - p) / nthread;
+
+  for (i = 0; i < nthread; i += 1) {
+    c[i].view.buf = (char*)p;
+    c[i].view.pos = 0;
+    c[i].view.mapped = 0;
+
+    if (i == nthread - 1) {
+      p = end;
+    } else {
+      p = MAX(p, in->buf + in->pos + (i + 1) * len);
+      p = memchr(p, '\n', end - p);
+      p = p == NULL ? end : p + 1;
+    }
+
+    c[i].view.size = p - c[i].view.buf;
+  }
+
+  run(c, nthread, count_chunk);
+
+  for (first = 0, i = 0; i < nthread; i += 1) {
+    c[i].x = x + first;
+    c[i].want = first >= count ? 0 : MIN(c[i].n, count - first);
+    first += c[i].want;
+  }
+
+  run(c, nthread, decode_chunk);
+
+  /* continue after the last integer that was asked for. */
+
+  in->pos = in->size;
+
+  for (i = 0; i < nthread; i += 1) {
+    if (c[i].want < c[i].n) {
+      in->pos = c[i].view.buf - in->buf + c[i].view.pos;
+      break;
+    }
+  }
+
+  in->seconds += now() - begin;
+
+  return first;
+}
+
+void input_report(input_t* in, FILE* f) {
+  fprintf(f, "parse = %zu bytes in %.3f s (%.1f MB/s)\n", in->pos,
+          in->seconds,
+          in->seconds > 0 ? in->pos / in->seconds / 1e6 : 0.0);
+}
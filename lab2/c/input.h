@@ -0,0 +1,48 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* the whole input is mapped (or read in large blocks when it is
+ * not a regular file) and integers are decoded straight from
+ * memory. any byte that is not a digit separates two integers.
+ *
+ */
+
+typedef struct input_t input_t;
+
+struct input_t {
+  char* buf;      /* all input bytes.		*/
+  size_t size;    /* number of bytes.		*/
+  size_t pos;     /* next byte to decode.		*/
+  int mapped;     /* buf is from mmap.		*/
+  double seconds; /* spent reading and decoding.	*/
+};
+
+void input_open(input_t* in, FILE* fp);
+void input_close(input_t* in);
+
+/* next integer, or 0 at end of input. */
+
+int input_int(input_t* in);
+
+/* decode the next count integers into x. returns how many there
+ * were before the end of the input.
+ *
+ */
+
+size_t input_ints(input_t* in, int* x, size_t count);
+
+/* the same with nthread threads that each decode a piece of the
+ * input starting at a line boundary.
+ *
+ */
+
+size_t input_ints_parallel(input_t* in, int* x, size_t count, int nthread);
+
+/* print bytes decoded and throughput on f. */
+
+void input_report(input_t* in, FILE* f);
+
+#endif /* INPUT_H */
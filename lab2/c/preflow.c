@@ -1,10 +1,21 @@
 #include <assert.h>
-#include <ctype.h>
+#include <limits.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#include "build.h"
+#include "counter.h"
+#include "cut.h"
+#include "flow.h"
+#include "graphfile.h"
+#include "input.h"
+#include "timebase.h"
 
 #define PRINT 0 /* enable/disable prints. */
 
@@ -30,31 +41,99 @@
 typedef struct graph_t graph_t;
 typedef struct node_t node_t;
 typedef struct edge_t edge_t;
-typedef struct list_t list_t;
+typedef struct edges_t edges_t;
 typedef struct work_args work_args;
+typedef struct shard_t shard_t;
+typedef struct anode_t anode_t;
+typedef struct lockfree_t lockfree_t;
+typedef struct lockfree_args lockfree_args;
+typedef struct cut_t cut_t;
+
+struct edges_t {
+  graph_t* g;
+  const int* x; /* edges as read.		*/
+  int directed; /* no capacity back.		*/
+};
+
+/* nodes with excess are kept on a stack of each thread, linked by
+ * next, and the older half is moved at once to a shard when the
+ * stack holds 2 * LOCAL, or sooner when some thread is idle. a
+ * thread with an empty stack takes the whole of one shard, its
+ * own first. a shard is a stack that is pushed to with a compare
+ * and swap and only ever emptied with an exchange, so a node that
+ * comes back to the same shard cannot fool a pop.
+ *
+ */
+
+#define LOCAL 32
+
+struct shard_t {
+  _Alignas(64) _Atomic(node_t*) head;
+  _Alignas(64) atomic_int inside; /* its thread is in a discharge. */
+};
 
 struct work_args {
   graph_t* g;
+  int i;        /* thread index.			*/
+  node_t* local; /* stack of nodes with excess.	*/
+  int size;     /* nodes on it.			*/
+  long moved;   /* batches given to shards.	*/
+  long taken;   /* shards emptied.		*/
+  long polls;   /* of shards found empty.	*/
+  long cas;     /* failed compare and swaps.	*/
+  long skipped; /* arcs to nodes held by others.	*/
+  long requeued; /* discharges given up for now.	*/
+  counters_t k; /* of this thread.		*/
+};
+
+/* state of the lock-free engine. the graph_t is only used for
+ * its adjacency arrays and capacities, and heights, excess and
+ * flow live in separate atomic arrays indexed as g->v and g->e.
+ *
+ * node u belongs to thread u % nthread which is the only one
+ * that lowers its excess, changes its height or takes it from
+ * its active stack. other threads only add excess to u and push
+ * it on the stack when its excess goes from zero to positive.
+ *
+ */
+
+struct anode_t {
+  atomic_int h;  /* height.			*/
+  _Atomic flow_t e; /* excess flow.		*/
+  anode_t* next; /* on the owner's active stack.	*/
+};
+
+struct lockfree_t {
+  graph_t* g;
+  int nthread;
+  anode_t* v;                 /* array of n nodes.		*/
+  _Atomic flow_t* f;          /* flow of each of the m edges.	*/
+  _Atomic(anode_t*)* active;  /* one stack per thread.	*/
+  atomic_int done;
 };
 
-struct list_t {
-  edge_t* edge;
-  list_t* next;
+struct lockfree_args {
+  lockfree_t* lf;
+  int i;        /* thread index.			*/
+  counters_t k; /* of this thread.		*/
 };
 
 struct node_t {
   int h;        /* height.			*/
-  int e;        /* excess flow.			*/
-  list_t* edge; /* adjacency list.		*/
+  flow_t e;     /* excess flow.			*/
+  int first;    /* of its edges in g->adj.	*/
+  int deg;       /* edges there.			*/
+  int cur;       /* current arc in it.		*/
+  atomic_flag lock; /* set while h, e or an edge changes.	*/
   node_t* next; /* with excess preflow.		*/
-  pthread_mutex_t mutex;
 };
 
 struct edge_t {
   node_t* u; /* one of the two nodes.	*/
   node_t* v; /* the other. 			*/
-  int f;     /* flow > 0 if from u to v.	*/
-  int c;     /* capacity.			*/
+  flow_t f;  /* flow > 0 if from u to v.	*/
+  flow_t c;  /* capacity.			*/
+  flow_t b;  /* capacity back from v to u.	*/
 };
 
 struct graph_t {
@@ -64,11 +143,21 @@ struct graph_t {
   edge_t* e;      /* array of m edges.		*/
   node_t* s;      /* source.			*/
   node_t* t;      /* sink.			*/
-  node_t* excess; /* nodes with e > 0 except s,t.	*/
-  pthread_mutex_t mutex;
+  edge_t** adj;   /* 2m, each node's edges together. */
+  shard_t* shard; /* one per thread.		*/
+  int nshard;
+  atomic_int busy;         /* threads with excess nodes.	*/
+  atomic_int* count;       /* nodes at each height < 2n.	*/
+  atomic_int pause;        /* set while a gap lifts nodes.	*/
+  int gaps;                /* gaps found.			*/
+  long lifted;             /* nodes lifted to n by gaps.	*/
+  double build;            /* seconds to lay out the edges. */
+  double init;             /* seconds of the initial push.	*/
+  counters_t k;            /* of all threads, with -DCOUNT=1. */
 };
 
 static char* progname;
+static int stop; /* at a maximum preflow, with -p.	*/
 
 #if PRINT
 
@@ -88,15 +177,6 @@ void error(const char* fmt, ...) {
   exit(1);
 }
 
-static int next_int() {
-  int x;
-  int c;
-  x = 0;
-  while (isdigit(c = getchar())) x = 10 * x + c - '0';
-
-  return x;
-}
-
 static void* xmalloc(size_t s) {
   void* p;
   p = malloc(s);
@@ -113,38 +193,42 @@ static void* xcalloc(size_t n, size_t s) {
   return p;
 }
 
-static void add_edge(node_t* u, edge_t* e) {
-  list_t* p;
-  p = xmalloc(sizeof(list_t));
-  p->edge = e;
-  p->next = u->edge;
-  u->edge = p;
-}
+static void connect(void* arg, int i, int j, int k) {
+  graph_t* g = ((edges_t*)arg)->g;
+  const int* x = ((edges_t*)arg)->x + 3 * i;
+  edge_t* e = &g->e[i];
 
-static void connect(node_t* u, node_t* v, int c, edge_t* e) {
   /* connect two nodes by putting a shared (same object)
-   * in their adjacency lists.
+   * in their adjacency arrays.
    *
    */
 
-  e->u = u;
-  e->v = v;
-  e->c = c;
+  e->u = &g->v[x[0]];
+  e->v = &g->v[x[1]];
+  e->c = x[2];
+  e->b = ((edges_t*)arg)->directed ? 0 : x[2];
 
-  add_edge(u, e);
-  add_edge(v, e);
+  g->adj[j] = e;
+  g->adj[k] = e;
 }
 
-static graph_t* new_graph(FILE* in, int n, int m) {
+static graph_t* new_graph(graphfile_t* gf, int nthread) {
+  edges_t edges;
   graph_t* g;
-  node_t* u;
-  node_t* v;
+  const int* off;
+  int* buf;
+  int n;
+  int m;
   int i;
-  int a;
-  int b;
-  int c;
 
-  g = xmalloc(sizeof(graph_t));
+  n = gf->n;
+  m = gf->m;
+
+  /* aligned for the counters in it. */
+
+  g = aligned_alloc(64, sizeof(graph_t));
+
+  if (g == NULL) error("out of memory: aligned_alloc failed");
 
   g->n = n;
   g->m = m;
@@ -154,45 +238,190 @@ static graph_t* new_graph(FILE* in, int n, int m) {
 
   g->s = &g->v[0];
   g->t = &g->v[n - 1];
-  g->excess = NULL;
-
-  for (i = 0; i < m; i += 1) {
-    a = next_int();
-    b = next_int();
-    c = next_int();
-    u = &g->v[a];
-    v = &g->v[b];
-    connect(u, v, c, g->e + i);
+  g->adj = xmalloc(2 * (size_t)m * sizeof(edge_t*));
+  g->shard = aligned_alloc(64, nthread * sizeof(shard_t));
+  g->nshard = nthread;
+
+  if (g->shard == NULL) error("out of memory: aligned_alloc failed");
+
+  for (i = 0; i < nthread; i += 1) {
+    atomic_init(&g->shard[i].head, NULL);
+    atomic_init(&g->shard[i].inside, 0);
   }
 
-  // pthread_mutexattr_t attr;
-  // pthread_mutexattr_init(&attr);
-  // pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  /* lay out the adjacency arrays with as many threads as will
+   * later push preflow, or only fill them in when the layout was
+   * saved in the graph file.
+   *
+   */
 
-  pthread_mutex_init(&g->mutex, NULL);
+  edges.g = g;
+  edges.x = gf->x;
+  edges.directed = (gf->flags & GRAPH_DIRECTED) != 0;
+  buf = NULL;
+
+  if (gf->at != NULL) {
+    off = gf->off;
+    g->build = build_from(gf->at, m, nthread, connect, &edges);
+  } else {
+    off = buf = xmalloc((n + 1) * sizeof(int));
+    g->build = build_csr(gf->x, n, m, nthread, buf, connect, &edges);
+  }
 
   for (i = 0; i < n; i += 1) {
-    pthread_mutex_init(&g->v[i].mutex, NULL);
+    g->v[i].first = off[i];
+    g->v[i].deg = off[i + 1] - off[i];
+    atomic_flag_clear(&g->v[i].lock);
   }
 
+  free(buf);
+
+  /* every node except s starts at height zero. */
+
+  g->count = xcalloc(2 * n + 1, sizeof(atomic_int));
+  atomic_init(&g->count[0], n - 1);
+  atomic_init(&g->pause, 0);
+  g->gaps = 0;
+  g->lifted = 0;
+  memset(&g->k, 0, sizeof g->k);
+
   return g;
 }
 
-static void enter_excess(graph_t* g, node_t* v) {
-  pthread_mutex_lock(&g->mutex);
-  if (v != g->t && v != g->s) {  // && v != g->s
-    v->next = g->excess;
-    g->excess = v;
+/* the lock of a node is one byte in what would otherwise be
+ * padding after cur, and its edges are found from an index into
+ * g->adj instead of a pointer, so with 32 bit flows a node_t is
+ * 32 bytes, two to a cache line, instead of 72 with a mutex. it is never waited for while another is
+ * held: a worker spins only for the node it discharges, and a
+ * neighbour that is held by someone else is skipped.
+ *
+ */
+
+static int trylock(node_t* u, counters_t* k) {
+  count(k, C_LOCK);
+
+  if (!atomic_flag_test_and_set_explicit(&u->lock, memory_order_acquire))
+    return 1;
+
+  count(k, C_CONTEND);
+
+  return 0;
+}
+
+static void lock(node_t* u, counters_t* k) {
+  while (!trylock(u, k)) sched_yield();
+}
+
+static void unlock(node_t* u) {
+  atomic_flag_clear_explicit(&u->lock, memory_order_release);
+}
+
+static void give(graph_t* g, int j, node_t* first, node_t* last,
+                 work_args* w) {
+  _Atomic(node_t*)* head;
+
+  /* put the chain from first to last on shard j. */
+
+  head = &g->shard[j].head;
+  last->next = atomic_load(head);
+
+  while (!atomic_compare_exchange_weak(head, &last->next, first)) {
+    w->cas += 1;
+    count(&w->k, C_CAS);
   }
-  pthread_mutex_unlock(&g->mutex);
 }
 
-static node_t* leave_excess(graph_t* g) {
+static void enter_excess(graph_t* g, node_t* v, work_args* w) {
+  node_t* last;
+  int keep;
+  int i;
+
+  if (v == g->t || v == g->s) return;
+
+  v->next = w->local;
+  w->local = v;
+  w->size += 1;
+
+  /* also share when some thread has nothing to do. */
+
+  if (w->size < 2 * LOCAL &&
+      (w->size < 2 || atomic_load_explicit(&g->busy, memory_order_relaxed) ==
+                          g->nshard))
+    return;
+
+  /* give the older half away so the newest stay here. */
+
+  keep = w->size / 2;
+
+  for (last = w->local, i = 1; i < keep; i += 1) last = last->next;
+
+  for (v = last->next; v->next != NULL; v = v->next)
+    ;
+
+  give(g, w->i, last->next, v, w);
+  last->next = NULL;
+  w->size = keep;
+  w->moved += 1;
+}
+
+static node_t* take(graph_t* g, work_args* w) {
   node_t* v;
-  pthread_mutex_lock(&g->mutex);
-  v = g->excess;
-  if (v != NULL) g->excess = v->next;
-  pthread_mutex_unlock(&g->mutex);
+  int j;
+  int n;
+
+  /* empty the first shard that is not, from this thread's own. */
+
+  for (j = 0; j < g->nshard; j += 1) {
+    if (atomic_load(&g->shard[(w->i + j) % g->nshard].head) == NULL) continue;
+
+    v = atomic_exchange(&g->shard[(w->i + j) % g->nshard].head, NULL);
+
+    if (v == NULL) continue;
+
+    for (n = 1, w->local = v; v->next != NULL; v = v->next) n += 1;
+
+    w->size = n;
+    w->taken += 1;
+
+    return w->local;
+  }
+
+  return NULL;
+}
+
+static node_t* leave_excess(graph_t* g, work_args* w) {
+  node_t* v;
+  int idle;
+
+  if (w->local == NULL && take(g, w) == NULL) {
+    /* wait until a shard has nodes or no thread is busy. only a
+     * busy thread can give a node excess, and a thread counts as
+     * busy while it takes nodes, so when none is busy and the
+     * shards are empty there is nothing left to do.
+     *
+     */
+
+    atomic_fetch_sub(&g->busy, 1);
+
+    for (;;) {
+      idle = atomic_load(&g->busy) == 0;
+      atomic_fetch_add(&g->busy, 1);
+
+      if (take(g, w) != NULL) break;
+
+      atomic_fetch_sub(&g->busy, 1);
+
+      if (idle) return NULL;
+
+      w->polls += 1;
+      sched_yield();
+    }
+  }
+
+  v = w->local;
+  w->local = v->next;
+  w->size -= 1;
+
   return v;
 }
 
@@ -203,80 +432,243 @@ static node_t* other(node_t* u, edge_t* e) {
     return e->u;
 }
 
-void lock_in_order(node_t* u, node_t* v) {
-  if (u < v) {
-    pthread_mutex_lock(&u->mutex);
-    pthread_mutex_lock(&v->mutex);
-  } else {
-    pthread_mutex_lock(&v->mutex);
-    pthread_mutex_lock(&u->mutex);
+static int direction(node_t* u, edge_t* e) { return (u == e->u) ? 1 : -1; }
+
+static flow_t available(edge_t* e, int dir) {
+  return dir > 0 ? e->c - e->f : e->b + e->f;
+}
+
+static void enter(graph_t* g, work_args* w) {
+  atomic_int* inside;
+
+  /* say that this thread is in a discharge unless a gap is being
+   * lifted, and otherwise wait until it is done. the flag is on a
+   * line of its own, so this costs no more than a fence, and pause
+   * is only read until a gap writes it.
+   *
+   */
+
+  inside = &g->shard[w->i].inside;
+
+  for (;;) {
+    atomic_store(inside, 1);
+
+    if (!atomic_load(&g->pause)) return;
+
+    atomic_store(inside, 0);
+
+    while (atomic_load_explicit(&g->pause, memory_order_relaxed))
+      sched_yield();
   }
 }
 
-static int direction(node_t* u, edge_t* e) { return (u == e->u) ? 1 : -1; }
+static void leave(graph_t* g, work_args* w) {
+  atomic_store_explicit(&g->shard[w->i].inside, 0, memory_order_release);
+}
+
+static void gap(graph_t* g, int k, work_args* w) {
+  node_t* u;
+  int i;
+
+  /* a worker saw the last node leave height k. once pause is set
+   * no worker starts a discharge, and when every other one is out
+   * of its current one the counts and heights are a consistent
+   * snapshot, so the gap can be checked again before anything is
+   * lifted. a gap found while another is lifted is dropped, which
+   * only leaves some relabels to be done.
+   *
+   */
+
+  if (atomic_exchange(&g->pause, 1)) return;
+
+  for (i = 0; i < g->nshard; i += 1)
+    while (i != w->i && atomic_load(&g->shard[i].inside)) sched_yield();
+
+  if (atomic_load(&g->count[k]) == 0) {
+    for (i = 0; i < g->n; i += 1) {
+      u = &g->v[i];
+      if (u != g->s && u->h > k && u->h < g->n) {
+        atomic_fetch_sub(&g->count[u->h], 1);
+        atomic_fetch_add(&g->count[g->n], 1);
+        u->h = g->n;
+        u->cur = 0;
+        g->lifted += 1;
+      }
+    }
 
-static int available(edge_t* e, int dir) { return e->c - dir * e->f; }
+    g->gaps += 1;
+  }
+
+  atomic_store(&g->pause, 0);
+}
 
 static void* work(void* arg) {
   pr("<--- thread started --->\n");
 
   node_t* nei;
   edge_t* edg;
-  list_t* adj;
   int dir;
-  int ava;
-  int flo;
+  flow_t ava;
+  node_t* next;
+  flow_t flo;
+  int skipped;
+  int first;
+  int start;
+  int min;
+  int h;
+  int i;
 
-  graph_t* g = ((work_args*)arg)->g;
+  work_args* w = arg;
+  graph_t* g = w->g;
+  counters_t* k = &w->k;
 
-  node_t* excess = leave_excess(g);
+  node_t* excess = leave_excess(g, w);
   while (excess != NULL) {
-    adj = excess->edge;
+    count(k, C_DISCHARGE);
+    h = -1;
+    skipped = 0;
+    first = -1;
+    min = INT_MAX;
+    enter(g, w);
+    lock(excess, k);
+
+    /* with -p the excess of a node that cannot reach t is left
+     * where it is instead of going back to s.
+     *
+     */
+
+    if (stop && excess->h >= g->n) {
+      unlock(excess);
+      leave(g, w);
+      excess = leave_excess(g, w);
+      continue;
+    }
 
-    while (adj != NULL) {
-      edg = adj->edge;
-      adj = adj->next;
+    start = excess->cur;
+
+    /* push along the arcs from the current one on while excess
+     * has excess. only the arcs of excess change while it is held,
+     * so their residual capacity can be read before nei is locked,
+     * and only nei->h needs it. an arc before the current one
+     * cannot become admissible until excess gets a new height, but
+     * one to a skipped neighbour has not been seen, so the current
+     * arc stays at the first of those. min is the lowest neighbour
+     * seen that could not be pushed to.
+     *
+     */
+
+    for (i = start; i < excess->deg && excess->e > 0; i += 1) {
+      edg = g->adj[excess->first + i];
 
       // Get direction and other node
       nei = other(excess, edg);
       dir = direction(excess, edg);
-
-      lock_in_order(excess, nei);
+      count(k, C_SCAN);
 
       ava = available(edg, dir);
 
-      if (excess->h > nei->h && ava > 0) {
-        break;
-      } else {
-        pthread_mutex_unlock(&excess->mutex);
-        pthread_mutex_unlock(&nei->mutex);
-        nei = NULL;
+      if (ava == 0 || nei == excess) continue;
+
+      if (!trylock(nei, k)) {
+        if (first < 0) first = i;
+        skipped += 1;
+        continue;
       }
-    }
 
-    // Push or relabel
-    if (nei != NULL) {
-      flo = MIN(excess->e, ava);
-      excess->e -= flo;
-      nei->e += flo;
-      edg->f += dir * flo;
+      if (excess->h > nei->h) {
+        flo = MIN(excess->e, ava);
+        excess->e -= flo;
+        nei->e += flo;
+        edg->f += dir * flo;
+        count(k, C_PUSH);
+
+        if (flo == ava) count(k, C_SATURATE);
+
+        if (nei->e == flo) {
+          enter_excess(g, nei, w);
+        }
+
+        /* stay on an arc that is not saturated. */
 
-      if (nei->e == flo) {
-        enter_excess(g, nei);
+        if (excess->e == 0) i -= 1;
+      } else if (nei->h < min) {
+        min = nei->h;
       }
 
-      pthread_mutex_unlock(&nei->mutex);
-    } else {
-      pthread_mutex_lock(&excess->mutex);
-      excess->h += 1;
+      unlock(nei);
+    }
+
+    excess->cur = first >= 0 ? first : i;
+
+    if (excess->e > 0 && skipped == 0) {
+      /* one above the lowest neighbour with residual capacity. a
+       * neighbour held by another thread is taken to be at the
+       * height of excess, which it was at least when its arc was
+       * passed, so the new height is still valid. only the arcs
+       * before the first scanned are left.
+       *
+       */
+
+      for (i = 0; i < start; i += 1) {
+        edg = g->adj[excess->first + i];
+        nei = other(excess, edg);
+        count(k, C_SCAN);
+
+        if (available(edg, direction(excess, edg)) == 0 || nei == excess)
+          continue;
+
+        if (trylock(nei, k)) {
+          if (nei->h < min) min = nei->h;
+          unlock(nei);
+        } else if (excess->h < min) {
+          min = excess->h;
+        }
+      }
+
+      h = excess->h;
+      excess->h = min + 1;
+      excess->cur = 0;
+      count(k, C_RELABEL);
+      atomic_fetch_add(&g->count[min + 1], 1);
+
+      if (atomic_fetch_sub(&g->count[h], 1) != 1 || h >= g->n) h = -1;
+    } else if (excess->e > 0) {
+      /* a skipped neighbour may be lower, so excess cannot be
+       * relabelled until every arc has been seen.
+       *
+       */
+
+      w->requeued += 1;
     }
 
+    w->skipped += skipped;
+
     if (excess->e == 0) {
-      pthread_mutex_unlock(&excess->mutex);
-      excess = leave_excess(g);
+      unlock(excess);
+      leave(g, w);
+      excess = leave_excess(g, w);
     } else {
-      pthread_mutex_unlock(&excess->mutex);
+      unlock(excess);
+      leave(g, w);
+
+      /* try another node before this one again, if there is one,
+       * and let the thread that holds the neighbour run, since the
+       * other nodes may well be waiting for the same one.
+       *
+       */
+
+      if (skipped > 0) {
+        if (w->local != NULL) {
+          next = leave_excess(g, w);
+          enter_excess(g, excess, w);
+          excess = next;
+        }
+
+        sched_yield();
+      }
     }
+
+    if (h >= 0) gap(g, h, w);
   }
 
   pr("<--- thread done --->\n");
@@ -284,92 +676,537 @@ static void* work(void* arg) {
   return 0;
 }
 
-static int preflow(graph_t* g, int nthread) {
+static flow_t preflow(graph_t* g, int nthread) {
+  pthread_t thread[nthread];
+  work_args args[nthread];
   node_t* src;
   node_t* nei;
   edge_t* edg;
-  list_t* adj;
   int dir;
+  flow_t ava;
+  long moved;
+  long taken;
+  long polls;
+  long cas;
+  long skipped;
+  long requeued;
   int i;
+  int j;
+
+  for (i = 0; i < nthread; i += 1) {
+    args[i].g = g;
+    args[i].i = i;
+    args[i].local = NULL;
+    args[i].size = 0;
+    args[i].moved = 0;
+    args[i].taken = 0;
+    args[i].polls = 0;
+    args[i].cas = 0;
+    args[i].skipped = 0;
+    args[i].requeued = 0;
+    memset(&args[i].k, 0, sizeof args[i].k);
+  }
+
+  atomic_init(&g->busy, nthread);
+  g->init = timebase_sec();
 
   src = g->s;
   src->h = g->n;
 
-  adj = src->edge;
-
-  // Initial push from source
-  while (adj != NULL) {
-    edg = adj->edge;
-    adj = adj->next;
+  // Initial push from source, dealt to the threads in turn
+  for (i = j = 0; i < src->deg; i += 1) {
+    edg = g->adj[src->first + i];
     nei = other(src, edg);
     dir = direction(src, edg);
-    edg->f += dir * edg->c;
-    nei->e += edg->c;
-    enter_excess(g, nei);
+    ava = available(edg, dir);
+
+    if (ava == 0) continue;
+
+    edg->f += dir * ava;
+    nei->e += ava;
+
+    /* a node with more than one edge from s already has a
+     * place after the first, and putting it on a stack again
+     * would make the stack a cycle.
+     *
+     */
+
+    if (nei->e == ava) enter_excess(g, nei, &args[j++ % nthread]);
   }
 
-  pthread_t thread[nthread];
-  work_args arg = {g};
+  g->init = timebase_sec() - g->init;
 
   for (i = 0; i < nthread; i += 1)
-    if (pthread_create(&thread[i], NULL, work, &arg) != 0)
+    if (pthread_create(&thread[i], NULL, work, &args[i]) != 0)
       error("pthread_create failed");
 
-  for (i = 0; i < nthread; i += 1)
+  moved = taken = polls = cas = skipped = requeued = 0;
+
+  for (i = 0; i < nthread; i += 1) {
     if (pthread_join(thread[i], NULL) != 0) error("pthread_join failed");
+    moved += args[i].moved;
+    taken += args[i].taken;
+    polls += args[i].polls;
+    cas += args[i].cas;
+    skipped += args[i].skipped;
+    requeued += args[i].requeued;
+    counters_add(&g->k, &args[i].k);
+  }
+
+  fprintf(stderr,
+          "excess: batches = %ld, shards taken = %ld, empty polls = %ld, "
+          "failed cas = %ld\n",
+          moved, taken, polls, cas);
+  fprintf(stderr, "locks: node = %zu bytes, skipped arcs = %ld, requeued = %ld\n",
+          sizeof(node_t), skipped, requeued);
 
   return g->t->e;
 }
 
-static void free_graph(graph_t* g) {
+static void lockfree_activate(lockfree_t* lf, anode_t* u, counters_t* k) {
+  _Atomic(anode_t*)* head;
+
+  head = &lf->active[(u - lf->v) % lf->nthread];
+  u->next = atomic_load(head);
+
+  while (!atomic_compare_exchange_weak(head, &u->next, u)) count(k, C_CAS);
+}
+
+static void lockfree_discharge(lockfree_t* lf, anode_t* u, counters_t* k) {
+  graph_t* g;
+  node_t* x;
+  anode_t* v;
+  anode_t* w;
+  edge_t* edg;
+  edge_t* low;
+  int dir;
+  flow_t ava;
+  int min;
+  int sat;
+  flow_t e;
+  int h;
+  flow_t d;
+  flow_t left;
+  int i;
+
+  g = lf->g;
+  x = &g->v[u - lf->v];
+
+  /* push to the lowest neighbour with residual capacity if it is
+   * below u, otherwise lift u to just above it. other threads
+   * can only add to u->e and to the residual capacity of the
+   * arcs leaving u, so the values read here are lower bounds.
+   *
+   */
+
+  count(k, C_DISCHARGE);
+
+  while ((e = atomic_load(&u->e)) > 0) {
+    min = INT_MAX;
+    low = NULL;
+    w = NULL;
+    d = 0;
+
+    for (i = 0; i < x->deg; i += 1) {
+      edg = g->adj[x->first + i];
+      dir = direction(x, edg);
+      ava = dir > 0 ? edg->c : edg->b;
+      ava -= dir * atomic_load(&lf->f[edg - g->e]);
+      count(k, C_SCAN);
+
+      if (ava <= 0) continue;
+
+      v = &lf->v[other(x, edg) - g->v];
+      h = atomic_load(&v->h);
+
+      if (h < min) {
+        min = h;
+        low = edg;
+        w = v;
+        d = dir * MIN(e, ava);
+        sat = e >= ava;
+      }
+    }
+
+    if (low == NULL) break;
+
+    if (atomic_load(&u->h) > min) {
+      atomic_fetch_add(&lf->f[low - g->e], d);
+      left = atomic_fetch_sub(&u->e, d < 0 ? -d : d) - (d < 0 ? -d : d);
+      count(k, C_PUSH);
+
+      if (sat) count(k, C_SATURATE);
+
+      if (atomic_fetch_add(&w->e, d < 0 ? -d : d) == 0 &&
+          w != &lf->v[g->s - g->v] && w != &lf->v[g->t - g->v])
+        lockfree_activate(lf, w, k);
+
+      /* once u has no excess another thread can give it more and
+       * put it on the stack again, so it is no longer ours.
+       *
+       */
+
+      if (left == 0) return;
+    } else {
+      atomic_store(&u->h, min + 1);
+      count(k, C_RELABEL);
+    }
+  }
+}
+
+static void* lockfree_work(void* arg) {
+  lockfree_t* lf;
+  anode_t* u;
+  anode_t* next;
+  anode_t* s;
+  anode_t* t;
+  counters_t* k;
+  int i;
+
+  lf = ((lockfree_args*)arg)->lf;
+  i = ((lockfree_args*)arg)->i;
+  k = &((lockfree_args*)arg)->k;
+  s = &lf->v[lf->g->s - lf->g->v];
+  t = &lf->v[lf->g->t - lf->g->v];
+
+  while (!atomic_load(&lf->done)) {
+    u = atomic_exchange(&lf->active[i], NULL);
+
+    if (u == NULL) {
+      /* all excess has reached s or t when their sum is zero.
+       * both only grow, so reading s first can never make
+       * the sum look zero too early.
+       *
+       */
+
+      if (atomic_load(&s->e) + atomic_load(&t->e) == 0)
+        atomic_store(&lf->done, 1);
+      else
+        sched_yield();
+
+      continue;
+    }
+
+    while (u != NULL) {
+      next = u->next;
+      lockfree_discharge(lf, u, k);
+      u = next;
+    }
+  }
+
+  return 0;
+}
+
+static flow_t lockfree_preflow(graph_t* g, int nthread) {
+  lockfree_t lf;
+  lockfree_args args[nthread];
+  pthread_t thread[nthread];
+  anode_t* s;
+  anode_t* v;
+  edge_t* edg;
+  int dir;
+  flow_t c;
+  flow_t f;
+  int i;
+
+  g->init = timebase_sec();
+
+  lf.g = g;
+  lf.nthread = nthread;
+  lf.v = xcalloc(g->n, sizeof(anode_t));
+  lf.f = xcalloc(g->m, sizeof(*lf.f));
+  lf.active = xcalloc(nthread, sizeof(*lf.active));
+  atomic_init(&lf.done, 0);
+
+  s = &lf.v[g->s - g->v];
+  atomic_store(&s->h, g->n);
+
+  // Initial push from source, s->e becomes minus the total
+  for (i = 0; i < g->s->deg; i += 1) {
+    edg = g->adj[g->s->first + i];
+    dir = direction(g->s, edg);
+    v = &lf.v[other(g->s, edg) - g->v];
+    c = dir > 0 ? edg->c : edg->b;
+    atomic_store(&lf.f[edg - g->e], dir * c);
+    atomic_fetch_sub(&s->e, c);
+
+    if (atomic_fetch_add(&v->e, c) == 0 && c > 0 && v != &lf.v[g->t - g->v])
+      lockfree_activate(&lf, v, &g->k);
+  }
+
+  g->init = timebase_sec() - g->init;
+
+  for (i = 0; i < nthread; i += 1) {
+    args[i].lf = &lf;
+    args[i].i = i;
+    memset(&args[i].k, 0, sizeof args[i].k);
+    if (pthread_create(&thread[i], NULL, lockfree_work, &args[i]) != 0)
+      error("pthread_create failed");
+  }
+
+  for (i = 0; i < nthread; i += 1) {
+    if (pthread_join(thread[i], NULL) != 0) error("pthread_join failed");
+    counters_add(&g->k, &args[i].k);
+  }
+
+  f = atomic_load(&lf.v[g->t - g->v].e);
+
+  /* leave the flow in the edges, as preflow does, for min_cut. */
+
+  for (i = 0; i < g->m; i += 1) g->e[i].f = atomic_load(&lf.f[i]);
+
+  free(lf.v);
+  free(lf.f);
+  free(lf.active);
+
+  return f;
+}
+
+/* the sink side of a minimum cut is the set of nodes that can still
+ * reach t in the residual graph, also when excess is left in nodes
+ * that cannot, and the rest is the source side. it is found by a
+ * breadth first search backwards from t with all threads taking
+ * nodes from one queue. a slot is claimed with a fetch and add on
+ * tail and filled after, so a thread that takes it may have to wait
+ * for the node. only a busy thread can add nodes, so a thread that
+ * saw no thread busy and then the queue empty can stop.
+ *
+ */
+
+struct cut_t {
+  graph_t* g;
+  atomic_char* sink;            /* can reach t.			*/
+  atomic_int* queue;            /* n nodes, -1 until filled.	*/
+  _Alignas(64) atomic_int head; /* next slot to take.		*/
+  _Alignas(64) atomic_int tail; /* next slot to fill.		*/
+  _Alignas(64) atomic_int busy; /* threads with a node.		*/
+};
+
+static void* cut_work(void* arg) {
+  cut_t* c = arg;
+  graph_t* g = c->g;
+  node_t* u;
+  node_t* v;
+  edge_t* e;
+  int head;
+  int idle;
+  int x;
   int i;
-  list_t* p;
-  list_t* q;
-
-  for (i = 0; i < g->n; i += 1) {
-    p = g->v[i].edge;
-    while (p != NULL) {
-      q = p->next;
-      free(p);
-      p = q;
+
+  for (;;) {
+    idle = atomic_load(&c->busy) == 0;
+    atomic_fetch_add(&c->busy, 1);
+    head = atomic_load(&c->head);
+
+    if (head >= atomic_load(&c->tail)) {
+      atomic_fetch_sub(&c->busy, 1);
+
+      if (idle) return NULL;
+
+      sched_yield();
+      continue;
+    }
+
+    if (!atomic_compare_exchange_weak(&c->head, &head, head + 1)) {
+      atomic_fetch_sub(&c->busy, 1);
+      continue;
     }
 
-    pthread_mutex_destroy(&g->v[i].mutex);
+    while ((x = atomic_load(&c->queue[head])) < 0) sched_yield();
+
+    v = &g->v[x];
+
+    for (i = 0; i < v->deg; i += 1) {
+      e = g->adj[v->first + i];
+      u = other(v, e);
+
+      /* u reaches t if it can push to v. */
+
+      if (available(e, direction(u, e)) > 0 &&
+          atomic_exchange(&c->sink[u - g->v], 1) == 0)
+        atomic_store(&c->queue[atomic_fetch_add(&c->tail, 1)], u - g->v);
+    }
+
+    atomic_fetch_sub(&c->busy, 1);
+  }
+}
+
+static void min_cut(graph_t* g, int nthread, flow_t f, FILE* fp, int binary) {
+  pthread_t thread[nthread];
+  cut_t c;
+  edge_t* e;
+  int* edge;  /* in the cut.			*/
+  int* node;  /* of the source side.		*/
+  int64_t sum; /* capacity of the cut.		*/
+  int k;
+  int s;
+  int i;
+  int a;
+  int b;
+
+  c.g = g;
+  c.sink = xcalloc(g->n, sizeof(atomic_char));
+  c.queue = xmalloc(g->n * sizeof(atomic_int));
+
+  for (i = 0; i < g->n; i += 1) atomic_init(&c.queue[i], -1);
+
+  atomic_init(&c.sink[g->t - g->v], 1);
+  atomic_init(&c.queue[0], g->t - g->v);
+  atomic_init(&c.head, 0);
+  atomic_init(&c.tail, 1);
+  atomic_init(&c.busy, 0);
+
+  for (i = 0; i < nthread; i += 1)
+    if (pthread_create(&thread[i], NULL, cut_work, &c) != 0)
+      error("pthread_create failed");
+
+  for (i = 0; i < nthread; i += 1)
+    if (pthread_join(thread[i], NULL) != 0) error("pthread_join failed");
+
+  /* the sink side is in the queue so the source side is the
+   * rest, and its nodes and the edges are found in order.
+   *
+   */
+
+  s = g->n - atomic_load(&c.tail);
+  node = xmalloc(s * sizeof(int));
+  edge = xmalloc(g->m * sizeof(int));
+  sum = 0;
+  k = 0;
+
+  for (i = s = 0; i < g->n; i += 1)
+    if (!atomic_load(&c.sink[i])) node[s++] = i;
+
+  for (i = 0; i < g->m; i += 1) {
+    e = &g->e[i];
+    a = atomic_load(&c.sink[e->u - g->v]);
+    b = atomic_load(&c.sink[e->v - g->v]);
+
+    if ((!a && b && e->c > 0) || (a && !b && e->b > 0)) {
+      edge[k++] = i;
+      sum += a ? e->b : e->c;
+    }
   }
 
-  pthread_mutex_destroy(&g->mutex);
+  if (sum != f)
+    error("cut of %" PRId64 " does not match f = %" PRIflow, sum, f);
+
+  fprintf(stderr, "cut = %d edges, source side = %d nodes\n", k, s);
+  cut_write(fp, binary, f, g->n, edge, k, node, s);
+
+  free(c.sink);
+  free(c.queue);
+  free(node);
+  free(edge);
+}
+
+static void free_graph(graph_t* g) {
+  free(g->count);
   free(g->v);
   free(g->e);
+  free(g->adj);
+  free(g->shard);
   free(g);
 }
 
 int main(int argc, char* argv[]) {
-  FILE* in;   /* input file set to stdin	*/
-  graph_t* g; /* undirected graph. 		*/
-  int f;      /* output from preflow.		*/
-  int n;      /* number of nodes.		*/
-  int m;      /* number of edges.		*/
+  input_t in;     /* all of stdin.			*/
+  graphfile_t gf; /* text or binary graph in it.	*/
+  graph_t* g;     /* undirected graph. 		*/
+  flow_t f;       /* output from preflow.		*/
+  int c;          /* command line option.		*/
+  int nthread = 4;
+  int lockfree = 0;
+  int binary = 0; /* cut in binary.			*/
+  char* cut = NULL; /* file for the minimum cut.	*/
+  FILE* fp;
+  double begin;   /* of the current phase.		*/
+  double teardown; /* freeing everything.		*/
 
   progname = argv[0]; /* name is a string in argv[0]. */
 
-  in = stdin; /* same as System.in in Java.	*/
+  while ((c = getopt(argc, argv, "bc:lpt:")) != -1) {
+    switch (c) {
+      case 'b':
+        binary = 1;
+        break;
+      case 'c':
+        cut = optarg;
+        break;
+      case 'l':
+        /* atomics instead of node locks and excess stacks. */
+        lockfree = 1;
+        break;
+      case 'p':
+        stop = 1;
+        break;
+      case 't':
+        nthread = atoi(optarg);
+        break;
+      default:
+        error("usage: %s [-l] [-p] [-c file [-b]] [-t threads] < input",
+              progname);
+    }
+  }
+
+  if (nthread < 1) error("need at least one thread");
+
+  if (stop && lockfree) error("-p needs the engine with locks");
 
-  n = next_int();
-  m = next_int();
+  init_timebase();
 
-  /* skip C and P from the 6railwayplanning lab in EDAF05 */
-  next_int();
-  next_int();
+  begin = timebase_sec();
+  input_open(&in, stdin);
+  graphfile_load(&gf, &in, nthread);
+  phase_report(stderr, "parse", timebase_sec() - begin);
+  flow_check(&gf);
 
-  g = new_graph(in, n, m);
+  begin = timebase_sec();
+  g = new_graph(&gf, nthread);
+  phase_report(stderr, "build", timebase_sec() - begin);
 
-  fclose(in);
+  begin = timebase_sec();
+  graphfile_free(&gf);
+  input_close(&in);
+  teardown = timebase_sec() - begin;
+  input_report(&in, stderr);
+  fprintf(stderr, "build = %.3f s (%d threads)\n", g->build, nthread);
+  flow_report(stderr, g->n * (sizeof(node_t) + lockfree * sizeof(anode_t)) +
+                          g->m * (sizeof(edge_t) + 2 * sizeof(edge_t*) +
+                                  lockfree * sizeof(flow_t)));
+
+  begin = timebase_sec();
+
+  if (lockfree)
+    f = lockfree_preflow(g, nthread);
+  else
+    f = preflow(g, nthread);
+
+  phase_report(stderr, "init", g->init);
+  phase_report(stderr, "solve", timebase_sec() - begin - g->init);
+
+  if (cut != NULL) {
+    begin = timebase_sec();
+
+    if ((fp = fopen(cut, binary ? "wb" : "w")) == NULL)
+      error("cannot open %s", cut);
+
+    min_cut(g, nthread, f, fp, binary);
+    fclose(fp);
+
+    phase_report(stderr, "cut", timebase_sec() - begin);
+  }
 
-  f = preflow(g, 4);
+  printf("f = %" PRIflow "\n", f);
+  counters_report(stdout, &g->k);
 
-  printf("f = %d\n", f);
+  if (!lockfree)
+    fprintf(stderr, "gaps = %d, lifted = %ld (%.1f per gap)\n", g->gaps,
+            g->lifted, g->gaps > 0 ? (double)g->lifted / g->gaps : 0.0);
 
+  begin = timebase_sec();
   free_graph(g);
+  phase_report(stderr, "teardown", teardown + timebase_sec() - begin);
 
   return 0;
 }
@@ -1,9 +1,15 @@
 #include <assert.h>
-#include <ctype.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+
+#include "counter.h"
+#include "flow.h"
+#include "graphfile.h"
+#include "input.h"
+#include "timebase.h"
 
 #define PRINT 0 /* enable/disable prints. */
 
@@ -26,10 +32,30 @@
 
 #define MIN(a, b) (((a) <= (b)) ? (a) : (b))
 
+/* a global relabel costs about ALPHA * n + m and is done again
+ * when the push/relabel work since the previous one, times the
+ * frequency set with -g, exceeds that. each relabel is charged
+ * BETA plus the number of arcs it scanned, and each push one.
+ *
+ */
+
+#define ALPHA 6
+#define BETA 12
+
+/* the order in which nodes with excess are selected, set with -s. */
+
+#define HIGHEST 0 /* greatest height first.		*/
+#define FIFO 1    /* oldest first.			*/
+#define LIFO 2    /* newest first.			*/
+#define ORDERS 3
+
+static const char* order_name[ORDERS] = {"highest", "fifo", "lifo"};
+
 typedef struct graph_t graph_t;
 typedef struct node_t node_t;
 typedef struct edge_t edge_t;
 typedef struct list_t list_t;
+typedef struct bucket_t bucket_t;
 
 struct list_t {
   edge_t* edge;
@@ -38,16 +64,30 @@ struct list_t {
 
 struct node_t {
   int h;        /* height.			*/
-  int e;        /* excess flow.			*/
+  flow_t e;     /* excess flow.			*/
   list_t* edge; /* adjacency list.		*/
-  node_t* next; /* with excess preflow.		*/
+  list_t* cur;  /* current arc in it.		*/
+  node_t* next; /* with excess preflow or in bucket.	*/
+  node_t* prev; /* in inactive bucket list.	*/
 };
 
 struct edge_t {
   node_t* u; /* one of the two nodes.	*/
   node_t* v; /* the other. 			*/
-  int f;     /* flow > 0 if from u to v.	*/
-  int c;     /* capacity.			*/
+  flow_t f;  /* flow > 0 if from u to v.	*/
+  flow_t c;  /* capacity.			*/
+  flow_t b;  /* capacity back from v to u.	*/
+};
+
+/* with HIGHEST every node except s and t is in the bucket of its
+ * height: in active if it has excess and else in inactive, which is
+ * doubly linked so that a node can leave it when it gets excess.
+ *
+ */
+
+struct bucket_t {
+  node_t* active;   /* e > 0, linked by next.	*/
+  node_t* inactive; /* e = 0, linked by next, prev.	*/
 };
 
 struct graph_t {
@@ -58,9 +98,25 @@ struct graph_t {
   node_t* s;      /* source.			*/
   node_t* t;      /* sink.			*/
   node_t* excess; /* nodes with e > 0 except s,t.	*/
+  node_t* last;   /* end of excess for FIFO.	*/
+  bucket_t* bucket; /* 2n + 1 heights for HIGHEST.	*/
+  int amax;       /* no active node above.	*/
+  int dmax;       /* no node below n above.	*/
+  node_t** queue; /* n nodes for global relabel.	*/
+  int* count;     /* nodes at each height < 2n.	*/
+  long work;      /* since last global relabel.	*/
+  int global;     /* global relabels done.		*/
+  int gaps;       /* gaps found.			*/
+  long lifted;    /* nodes lifted to n by gaps.	*/
+  long pushes;    /* pushes done.			*/
+  long relabels;  /* relabels done.		*/
+  double init;    /* seconds of the initial push.	*/
+  counters_t k;   /* with -DCOUNT=1.		*/
 };
 
 static char* progname;
+static double freq = 0.5; /* global relabel frequency.	*/
+static int order = HIGHEST; /* selection order.		*/
 
 #if PRINT
 
@@ -80,15 +136,6 @@ void error(const char* fmt, ...) {
   exit(1);
 }
 
-static int next_int() {
-  int x;
-  int c;
-  x = 0;
-  while (isdigit(c = getchar())) x = 10 * x + c - '0';
-
-  return x;
-}
-
 static void* xmalloc(size_t s) {
   void* p;
   p = malloc(s);
@@ -119,7 +166,7 @@ static void add_edge(node_t* u, edge_t* e) {
   u->edge = p;
 }
 
-static void connect(node_t* u, node_t* v, int c, edge_t* e) {
+static void connect(node_t* u, node_t* v, flow_t c, flow_t b, edge_t* e) {
   /* connect two nodes by putting a shared (same object)
    * in their adjacency lists.
    *
@@ -128,21 +175,32 @@ static void connect(node_t* u, node_t* v, int c, edge_t* e) {
   e->u = u;
   e->v = v;
   e->c = c;
+  e->b = b;
 
   add_edge(u, e);
   add_edge(v, e);
 }
 
-static graph_t* new_graph(FILE* in, int n, int m) {
+static graph_t* new_graph(graphfile_t* gf) {
   graph_t* g;
+  const int* x;
   node_t* u;
   node_t* v;
   int i;
   int a;
   int b;
   int c;
+  int n;
+  int m;
+
+  n = gf->n;
+  m = gf->m;
+  x = gf->x;
+  /* aligned for the counters in it. */
+
+  g = aligned_alloc(64, sizeof(graph_t));
 
-  g = xmalloc(sizeof(graph_t));
+  if (g == NULL) error("out of memory: aligned_alloc failed");
 
   g->n = n;
   g->m = m;
@@ -153,80 +211,169 @@ static graph_t* new_graph(FILE* in, int n, int m) {
   g->s = &g->v[0];
   g->t = &g->v[n - 1];
   g->excess = NULL;
+  g->last = NULL;
+  g->bucket = xcalloc(2 * n + 1, sizeof(bucket_t));
+  g->amax = -1;
+  g->dmax = 0;
+  g->queue = xmalloc(n * sizeof(node_t*));
+  g->count = xcalloc(2 * n + 1, sizeof(int));
+  g->work = 0;
+  g->global = 0;
+  g->gaps = 0;
+  g->lifted = 0;
+  g->pushes = 0;
+  g->relabels = 0;
+  memset(&g->k, 0, sizeof g->k);
 
   for (i = 0; i < m; i += 1) {
-    a = next_int();
-    b = next_int();
-    c = next_int();
+    a = x[3 * i];
+    b = x[3 * i + 1];
+    c = x[3 * i + 2];
     u = &g->v[a];
     v = &g->v[b];
-    connect(u, v, c, g->e + i);
+    connect(u, v, c, gf->flags & GRAPH_DIRECTED ? 0 : c, g->e + i);
   }
 
   return g;
 }
 
 static void enter_excess(graph_t* g, node_t* v) {
-  /* put v at the front of the list of nodes
-   * that have excess preflow > 0.
-   *
-   * note that for the algorithm, this is just
-   * a set of nodes which has no order but putting it
-   * it first is simplest.
+  bucket_t* b;
+
+  /* put v, which is in no list, among the nodes that have
+   * excess preflow > 0: at the front for LIFO, at the end
+   * for FIFO and first in the bucket of its height for HIGHEST.
    *
    */
 
-  if (v != g->t && v != g->s) {
-    v->next = g->excess;
-    g->excess = v;
+  if (v == g->t || v == g->s) return;
+
+  switch (order) {
+    case HIGHEST:
+      b = &g->bucket[v->h];
+      v->next = b->active;
+      b->active = v;
+      if (v->h > g->amax) g->amax = v->h;
+      break;
+
+    case FIFO:
+      v->next = NULL;
+      if (g->last != NULL)
+        g->last->next = v;
+      else
+        g->excess = v;
+      g->last = v;
+      break;
+
+    case LIFO:
+      v->next = g->excess;
+      g->excess = v;
+      break;
   }
 }
 
 static node_t* leave_excess(graph_t* g) {
+  bucket_t* b;
   node_t* v;
 
-  /* take any node from the set of nodes with excess preflow
-   * and for simplicity we always take the first.
+  /* take the node that the order selects from the set of
+   * nodes with excess preflow. no bucket above amax has an
+   * active node so the highest is found by going down.
    *
    */
 
+  if (order == HIGHEST) {
+    while (g->amax >= 0 && g->bucket[g->amax].active == NULL) g->amax -= 1;
+
+    if (g->amax < 0) return NULL;
+
+    b = &g->bucket[g->amax];
+    v = b->active;
+    b->active = v->next;
+
+    return v;
+  }
+
   v = g->excess;
 
   if (v != NULL) g->excess = v->next;
 
+  if (v == g->last) g->last = NULL;
+
   return v;
 }
 
+static void enter_inactive(graph_t* g, node_t* v) {
+  bucket_t* b;
+
+  if (order != HIGHEST || v == g->t || v == g->s) return;
+
+  b = &g->bucket[v->h];
+  v->prev = NULL;
+  v->next = b->inactive;
+  if (b->inactive != NULL) b->inactive->prev = v;
+  b->inactive = v;
+}
+
+static void leave_inactive(graph_t* g, node_t* v) {
+  bucket_t* b;
+
+  if (order != HIGHEST || v == g->t || v == g->s) return;
+
+  b = &g->bucket[v->h];
+  if (v->prev != NULL)
+    v->prev->next = v->next;
+  else
+    b->inactive = v->next;
+  if (v->next != NULL) v->next->prev = v->prev;
+}
+
+static void fill_buckets(graph_t* g) {
+  node_t* v;
+  int i;
+
+  /* put every node in the bucket of its height. */
+
+  memset(g->bucket, 0, (2 * g->n + 1) * sizeof(bucket_t));
+  g->amax = -1;
+
+  for (i = 0; i < g->n; i += 1) {
+    v = &g->v[i];
+    if (v->e > 0)
+      enter_excess(g, v);
+    else
+      enter_inactive(g, v);
+  }
+}
+
 static void push(graph_t* g, node_t* u, node_t* v, edge_t* e) {
-  int d; /* remaining capacity of the edge. */
+  flow_t d; /* remaining capacity of the edge. */
 
   pr("push from %d to %d: ", id(g, u), id(g, v));
-  pr("f = %d, c = %d, so ", e->f, e->c);
+  pr("f = %" PRIflow ", c = %" PRIflow ", so ", e->f, e->c);
 
   if (u == e->u) {
     d = MIN(u->e, e->c - e->f);
     e->f += d;
+    if (e->f == e->c) count(&g->k, C_SATURATE);
   } else {
-    d = MIN(u->e, e->c + e->f);
+    d = MIN(u->e, e->b + e->f);
     e->f -= d;
+    if (e->f == -e->b) count(&g->k, C_SATURATE);
   }
 
-  pr("pushing %d\n", d);
+  pr("pushing %" PRIflow "\n", d);
 
   u->e -= d;
   v->e += d;
+  g->pushes += 1;
+  count(&g->k, C_PUSH);
 
   /* the following are always true. */
 
   assert(d >= 0);
   assert(u->e >= 0);
-  assert(abs(e->f) <= e->c);
-
-  if (u->e > 0) {
-    /* still some remaining so let u push more. */
-
-    enter_excess(g, u);
-  }
+  assert(-e->b <= e->f && e->f <= e->c);
 
   if (v->e == d) {
     /* since v has d excess now it had zero before and
@@ -234,18 +381,11 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e) {
      *
      */
 
+    leave_inactive(g, v);
     enter_excess(g, v);
   }
 }
 
-static void relabel(graph_t* g, node_t* u) {
-  u->h += 1;
-
-  pr("relabel %d now h = %d\n", id(g, u), u->h);
-
-  enter_excess(g, u);
-}
-
 static node_t* other(node_t* u, edge_t* e) {
   if (u == e->u)
     return e->v;
@@ -253,17 +393,247 @@ static node_t* other(node_t* u, edge_t* e) {
     return e->u;
 }
 
-static int preflow(graph_t* g) {
-  node_t* s;
+static void set_height(graph_t* g, node_t* u, int h) {
+  g->count[u->h] -= 1;
+  g->count[h] += 1;
+  u->h = h;
+  u->cur = u->edge;
+
+  if (h < g->n && h > g->dmax) g->dmax = h;
+}
+
+static void lift(graph_t* g, node_t* u) {
+  set_height(g, u, g->n);
+  g->lifted += 1;
+}
+
+static void gap(graph_t* g, int k) {
+  bucket_t* b;
   node_t* u;
+  int i;
+
+  /* no node has height k so no node above it can reach t
+   * and they can all go straight to n. with buckets only
+   * the heights from k + 1 to dmax need to be emptied.
+   *
+   */
+
+  if (order == HIGHEST) {
+    for (i = k + 1; i <= g->dmax; i += 1) {
+      b = &g->bucket[i];
+
+      while ((u = b->active) != NULL) {
+        b->active = u->next;
+        lift(g, u);
+        enter_excess(g, u);
+      }
+
+      while ((u = b->inactive) != NULL) {
+        b->inactive = u->next;
+        lift(g, u);
+        enter_inactive(g, u);
+      }
+    }
+
+    g->dmax = k - 1;
+  } else {
+    for (i = 0; i < g->n; i += 1) {
+      u = &g->v[i];
+      if (u != g->s && u->h > k && u->h < g->n) lift(g, u);
+    }
+  }
+
+  g->gaps += 1;
+
+  pr("gap at %d\n", k);
+}
+
+static void relabel(graph_t* g, node_t* u, int min, list_t* end) {
   node_t* v;
   edge_t* e;
   list_t* p;
+  int h;
+
+  /* one above the lowest neighbour that u can push to. there is
+   * always one since the excess of u came over some arc that can
+   * take it back. min is the lowest on the arcs from end on, which
+   * discharge has just scanned, so only those before end are left.
+   *
+   */
+
+  for (p = u->edge; p != end; p = p->next) {
+    e = p->edge;
+    v = other(u, e);
+    g->work += 1;
+    count(&g->k, C_SCAN);
+
+    if (v->h < min && (u == e->u ? e->c - e->f : e->b + e->f) > 0) min = v->h;
+  }
+
+  assert(min < 2 * g->n - 1);
+
+  h = u->h;
+  set_height(g, u, min + 1);
+  g->work += BETA;
+  g->relabels += 1;
+  count(&g->k, C_RELABEL);
+
+  pr("relabel %d now h = %d\n", id(g, u), u->h);
+
+  enter_excess(g, u);
+
+  if (g->count[h] == 0 && h < g->n) gap(g, h);
+}
+
+static void discharge(graph_t* g, node_t* u) {
+  node_t* v;
+  edge_t* e;
+  list_t* start;
+  int min;
   int b;
 
+  /* push along the arcs from the current one on until u has no
+   * excess left, and relabel if it runs out of arcs first. an arc
+   * before the current one cannot become admissible until u gets
+   * a new height, since a push back over it needs v above u, so
+   * they are not scanned again.
+   *
+   */
+
+  start = u->cur;
+  min = 2 * g->n;
+
+  while (u->e > 0) {
+    if (u->cur == NULL) {
+      relabel(g, u, min, start);
+      return;
+    }
+
+    e = u->cur->edge;
+    g->work += 1;
+    count(&g->k, C_SCAN);
+
+    if (u == e->u) {
+      v = e->v;
+      b = 1;
+    } else {
+      v = e->u;
+      b = -1;
+    }
+
+    if (u->h > v->h && (b > 0 ? e->c - e->f : e->b + e->f) > 0) {
+      push(g, u, v, e);
+
+      /* excess left means the arc is saturated. */
+
+      if (u->e > 0) u->cur = u->cur->next;
+    } else {
+      if ((b > 0 ? e->c - e->f : e->b + e->f) > 0 && v->h < min) min = v->h;
+
+      u->cur = u->cur->next;
+    }
+  }
+
+  enter_inactive(g, u);
+}
+
+static int bfs(graph_t* g, node_t* r, int tail) {
+  node_t* u;
+  node_t* v;
+  edge_t* e;
+  list_t* p;
+  int head;
+  int base;
+
+  /* label every node not yet labeled that can reach r in the
+   * residual graph with its distance to r plus the height of r.
+   * nodes that are not labeled have height 2n.
+   *
+   */
+
+  base = tail;
+  g->queue[tail++] = r;
+
+  for (head = base; head < tail; head += 1) {
+    v = g->queue[head];
+
+    for (p = v->edge; p != NULL; p = p->next) {
+      e = p->edge;
+      u = other(v, e);
+
+      if (u->h < 2 * g->n) continue;
+
+      /* residual capacity from u to v. */
+
+      if ((u == e->u ? e->c - e->f : e->b + e->f) > 0) {
+        u->h = v->h + 1;
+        g->queue[tail++] = u;
+      }
+    }
+  }
+
+  return tail;
+}
+
+static void global_relabel(graph_t* g) {
+  int tail;
+  int i;
+
+  /* set every height to the exact distance to t in the residual
+   * graph by a breadth first search backwards from t. nodes that
+   * cannot reach t get n plus their distance to s, so that their
+   * excess finds its way back to s. giving them all n instead
+   * lets excess circle between them forever when relabels only
+   * add one, since the next global relabel undoes the climb.
+   * nodes that reach neither have no excess and keep n.
+   *
+   */
+
+  for (i = 0; i < g->n; i += 1) {
+    g->v[i].h = 2 * g->n;
+    g->v[i].cur = g->v[i].edge;
+  }
+
+  g->t->h = 0;
+  g->s->h = g->n;
+  tail = bfs(g, g->t, 0);
+  tail = bfs(g, g->s, tail);
+
+  for (i = 0; i < g->n; i += 1)
+    if (g->v[i].h == 2 * g->n) g->v[i].h = g->n;
+
+  memset(g->count, 0, (2 * g->n + 1) * sizeof(int));
+
+  for (i = 0; i < g->n; i += 1)
+    if (&g->v[i] != g->s) g->count[g->v[i].h] += 1;
+
+  g->dmax = 0;
+
+  for (i = 0; i < g->n; i += 1)
+    if (g->v[i].h < g->n && g->v[i].h > g->dmax) g->dmax = g->v[i].h;
+
+  if (order == HIGHEST) fill_buckets(g);
+
+  g->work = 0;
+  g->global += 1;
+
+  pr("global relabel %d reached %d nodes\n", g->global, tail);
+}
+
+static flow_t preflow(graph_t* g) {
+  node_t* s;
+  node_t* u;
+  edge_t* e;
+  list_t* p;
+  flow_t b;
+
+  g->init = timebase_sec();
+
   s = g->s;
   s->h = g->n;
 
+  if (order == HIGHEST) fill_buckets(g);
+
   p = s->edge;
 
   /* start by pushing as much as possible (limited by
@@ -274,52 +644,31 @@ static int preflow(graph_t* g) {
   while (p != NULL) {
     e = p->edge;
     p = p->next;
+    b = s == e->u ? e->c : e->b;
 
-    s->e += e->c;
-    push(g, s, other(s, e), e);
+    if (b > 0) {
+      s->e += b;
+      push(g, s, other(s, e), e);
+    }
   }
 
+  g->init = timebase_sec() - g->init;
+
+  global_relabel(g);
+
   /* then loop until only s and/or t have excess preflow. */
 
   while ((u = leave_excess(g)) != NULL) {
     /* u is any node with excess preflow. */
 
-    pr("selected u = %d with ", id(g, u));
-    pr("h = %d and e = %d\n", u->h, u->e);
-
-    /* if we can push we must push and only if we could
-     * not push anything, we are allowed to relabel.
-     *
-     * we can push to multiple nodes if we wish but
-     * here we just push once for simplicity.
-     *
-     */
-
-    v = NULL;
-    p = u->edge;
+    count(&g->k, C_DISCHARGE);
 
-    while (p != NULL) {
-      e = p->edge;
-      p = p->next;
-
-      if (u == e->u) {
-        v = e->v;
-        b = 1;
-      } else {
-        v = e->u;
-        b = -1;
-      }
+    pr("selected u = %d with ", id(g, u));
+    pr("h = %d and e = %" PRIflow "\n", u->h, u->e);
 
-      if (u->h > v->h && b * e->f < e->c)
-        break;
-      else
-        v = NULL;
-    }
+    discharge(g, u);
 
-    if (v != NULL)
-      push(g, u, v, e);
-    else
-      relabel(g, u);
+    if (freq > 0 && g->work * freq > ALPHA * g->n + g->m) global_relabel(g);
   }
 
   return g->t->e;
@@ -340,36 +689,115 @@ static void free_graph(graph_t* g) {
   }
   free(g->v);
   free(g->e);
+  free(g->queue);
+  free(g->count);
+  free(g->bucket);
   free(g);
 }
 
+static void report(graph_t* g) {
+  fprintf(stderr, "%s: pushes = %ld, relabels = %ld\n", order_name[order],
+          g->pushes, g->relabels);
+  fprintf(stderr, "global relabels = %d (freq = %g, every %ld work)\n",
+          g->global, freq,
+          freq > 0 ? (long)((ALPHA * g->n + g->m) / freq) : 0L);
+  fprintf(stderr, "gaps = %d, lifted = %ld (%.1f per gap)\n", g->gaps,
+          g->lifted, g->gaps > 0 ? (double)g->lifted / g->gaps : 0.0);
+}
+
 int main(int argc, char* argv[]) {
-  FILE* in;   /* input file set to stdin	*/
-  graph_t* g; /* undirected graph. 		*/
-  int f;      /* output from preflow.		*/
-  int n;      /* number of nodes.		*/
-  int m;      /* number of edges.		*/
+  input_t in;     /* all of stdin.			*/
+  graphfile_t gf; /* text or binary graph in it.	*/
+  graph_t* g;     /* undirected graph. 		*/
+  flow_t f;       /* output from preflow.		*/
+  flow_t h;       /* of the current order.		*/
+  int c;          /* command line option.		*/
+  double begin;   /* of the current phase.		*/
+  double teardown; /* freeing everything.		*/
+  counters_t k[ORDERS]; /* of each order run.	*/
+  int first;      /* orders to run.			*/
+  int end;
 
   progname = argv[0]; /* name is a string in argv[0]. */
+  first = HIGHEST;
+  end = HIGHEST + 1;
+
+  while ((c = getopt(argc, argv, "g:s:")) != -1) {
+    switch (c) {
+      case 'g':
+        /* 0 means only the initial global relabel. */
+        freq = atof(optarg);
+        break;
+      case 's':
+        /* all runs every order on the same graph. */
+        first = 0;
+        end = ORDERS;
+        if (strcmp(optarg, "all") == 0) break;
+        while (first < ORDERS && strcmp(optarg, order_name[first]) != 0)
+          first += 1;
+        if (first == ORDERS) error("unknown order %s", optarg);
+        end = first + 1;
+        break;
+      default:
+        error("usage: %s [-g freq] [-s highest|fifo|lifo|all] < input",
+              progname);
+    }
+  }
 
-  in = stdin; /* same as System.in in Java.	*/
-
-  n = next_int();
-  m = next_int();
-
-  /* skip C and P from the 6railwayplanning lab in EDAF05 */
-  next_int();
-  next_int();
+  init_timebase();
+
+  begin = timebase_sec();
+  input_open(&in, stdin);
+  graphfile_load(&gf, &in, 1);
+  phase_report(stderr, "parse", timebase_sec() - begin);
+  input_report(&in, stderr);
+  flow_check(&gf);
+
+  f = 0;
+  teardown = 0;
+
+  for (order = first; order < end; order += 1) {
+    begin = timebase_sec();
+    g = new_graph(&gf);
+    phase_report(stderr, "build", timebase_sec() - begin);
+
+    begin = timebase_sec();
+    h = preflow(g);
+    phase_report(stderr, "init", g->init);
+    phase_report(stderr, "solve", timebase_sec() - begin - g->init);
+
+    if (order > first && h != f)
+      error("%s gives f = %" PRIflow " but %s gives %" PRIflow,
+            order_name[order], h, order_name[first], f);
+
+    f = h;
+    report(g);
+    flow_report(stderr, g->n * sizeof(node_t) +
+                            g->m * (sizeof(edge_t) + 2 * sizeof(list_t)));
+    k[order] = g->k;
+
+    begin = timebase_sec();
+    free_graph(g);
+    teardown += timebase_sec() - begin;
+  }
 
-  g = new_graph(in, n, m);
+  begin = timebase_sec();
+  graphfile_free(&gf);
+  input_close(&in);
+  phase_report(stderr, "teardown", teardown + timebase_sec() - begin);
 
-  fclose(in);
+  printf("f = %" PRIflow "\n", f);
 
-  f = preflow(g);
+  /* each order has its own counts, since a sum of them would be
+   * the counts of no run.
+   *
+   */
 
-  printf("f = %d\n", f);
+  for (order = first; order < end; order += 1) {
+    if (COUNT && end - first > 1) printf("order %s\n", order_name[order]);
 
-  free_graph(g);
+    counters_report(stdout, &k[order]);
+  }
 
   return 0;
 }
@@ -0,0 +1,247 @@
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "graphfile.h"
+#include "input.h"
+#include "solver.h"
+#include "timebase.h"
+
+/* solve a graph on stdin with the solver library, a number of
+ * times with -r to see that solving again allocates nothing.
+ *
+ * with -q it answers the railway planning question instead: the
+ * routes are removed in the given order for as long as the flow
+ * stays at least C, and how many could go and the flow after
+ * removing them are printed.
+ *
+ * with -b it answers the same question by searching for the
+ * longest prefix of the routes that can go, solving from scratch
+ * at -t prefix lengths at once in as many threads.
+ *
+ */
+
+typedef struct probe_t probe_t;
+
+struct probe_t {
+  solver_t* sv;     /* share of the loaded graph.	*/
+  graphfile_t* gf;
+  int k;            /* routes removed.		*/
+  int f;            /* flow without them.		*/
+};
+
+static char* progname;
+static int query;  /* answer the railway planning question. */
+static int bisect; /* the same by searching over prefixes.   */
+
+void error(const char* fmt, ...) {
+  va_list ap;
+  char buf[BUFSIZ];
+
+  va_start(ap, fmt);
+  vsprintf(buf, fmt, ap);
+
+  if (progname != NULL) fprintf(stderr, "%s: ", progname);
+
+  fprintf(stderr, "error: %s\n", buf);
+  exit(1);
+}
+
+static void railway(solver_t* sv, graphfile_t* gf, int f) {
+  double begin;
+  double sec;
+  int done; /* removals made.		*/
+  int g;
+  int k;
+
+  /* remove routes until one more would take the flow below C.
+   * the solver only moves the flow of each removed route.
+   *
+   */
+
+  begin = timebase_sec();
+
+  for (k = 0; k < gf->p; k += 1) {
+    if (gf->route[k] < 0 || gf->route[k] >= gf->m)
+      error("route %d is not an edge", gf->route[k]);
+
+    if ((g = solver_remove(sv, gf->route[k])) < gf->c) break;
+
+    f = g;
+  }
+
+  sec = timebase_sec() - begin;
+  done = k < gf->p ? k + 1 : k;
+
+  printf("%d %d\n", k, f);
+
+  phase_report(stderr, "query", sec);
+  fprintf(stderr, "removals = %d, %.3f us per removal\n", done,
+          done > 0 ? sec * 1e6 / done : 0.0);
+}
+
+static void* probe(void* arg) {
+  probe_t* p = arg;
+
+  p->f = solver_solve_without(p->sv, p->gf->route, p->k);
+
+  return NULL;
+}
+
+static void search(solver_t* sv, graphfile_t* gf, int f, int nthread) {
+  pthread_t thread[nthread];
+  probe_t p[nthread];
+  double begin;
+  double sec;
+  int solves; /* of all threads.		*/
+  int rounds;
+  int lo;     /* this many can go,		*/
+  int hi;     /* but not this many.		*/
+  int n;      /* probes this round.		*/
+  int i;
+
+  /* the flow never grows as more routes go, so the answer is the
+   * last prefix with flow at least C. each round solves at up to
+   * nthread lengths spread evenly between lo and hi, which cuts
+   * the range to about 1 / (nthread + 1) of what it was.
+   *
+   */
+
+  begin = timebase_sec();
+
+  for (i = 0; i < gf->p; i += 1)
+    if (gf->route[i] < 0 || gf->route[i] >= gf->m)
+      error("route %d is not an edge", gf->route[i]);
+
+  for (i = 0; i < nthread; i += 1) {
+    p[i].gf = gf;
+    if ((p[i].sv = solver_share(sv)) == NULL) error("out of memory");
+  }
+
+  lo = 0;
+  hi = f < gf->c ? 0 : gf->p + 1;
+  solves = 0;
+  rounds = 0;
+
+  while (hi - lo > 1) {
+    n = hi - lo - 1 < nthread ? hi - lo - 1 : nthread;
+
+    for (i = 0; i < n; i += 1) {
+      p[i].k = lo + (long)(hi - lo) * (i + 1) / (n + 1);
+      if (pthread_create(&thread[i], NULL, probe, &p[i]) != 0)
+        error("pthread_create failed");
+    }
+
+    for (i = 0; i < n; i += 1)
+      if (pthread_join(thread[i], NULL) != 0) error("pthread_join failed");
+
+    /* the lengths grow with i so the first that fails ends it. */
+
+    for (i = 0; i < n && p[i].f >= gf->c; i += 1) {
+      lo = p[i].k;
+      f = p[i].f;
+    }
+
+    if (i < n) hi = p[i].k;
+
+    solves += n;
+    rounds += 1;
+  }
+
+  for (i = 0; i < nthread; i += 1) solver_free(p[i].sv);
+
+  sec = timebase_sec() - begin;
+
+  printf("%d %d\n", lo, f);
+
+  phase_report(stderr, "query", sec);
+  fprintf(stderr, "solves = %d in %d rounds of %d threads\n", solves, rounds,
+          nthread);
+}
+
+int main(int argc, char* argv[]) {
+  input_t in;     /* all of stdin.			*/
+  graphfile_t gf; /* text or binary graph in it.	*/
+  solver_t* sv;   /* kept for every run.		*/
+  double begin;   /* of the current phase.		*/
+  long allocs;    /* after the first run.		*/
+  int runs = 1;
+  int nthread = 4;
+  int f;
+  int c;
+  int i;
+
+  progname = argv[0]; /* name is a string in argv[0]. */
+
+  while ((c = getopt(argc, argv, "bqr:t:")) != -1) {
+    switch (c) {
+      case 'b':
+        bisect = 1;
+        break;
+      case 'q':
+        query = 1;
+        break;
+      case 'r':
+        runs = atoi(optarg);
+        break;
+      case 't':
+        nthread = atoi(optarg);
+        break;
+      default:
+        error("usage: %s [-b] [-q] [-r runs] [-t threads] < input", progname);
+    }
+  }
+
+  if (runs < 1) error("need at least one run");
+
+  if (nthread < 1) error("need at least one thread");
+
+  init_timebase();
+
+  begin = timebase_sec();
+  input_open(&in, stdin);
+  graphfile_load(&gf, &in, 1);
+  phase_report(stderr, "parse", timebase_sec() - begin);
+
+  if (gf.flags & GRAPH_DIRECTED) error("the solver takes undirected edges");
+
+  if ((sv = solver_new(0, 0)) == NULL) error("out of memory");
+
+  f = 0;
+  allocs = 0;
+
+  /* the edges are triples of ints just like xedge_t. */
+
+  for (i = 0; i < runs; i += 1) {
+    begin = timebase_sec();
+    if (solver_load(sv, gf.n, gf.m, 0, gf.n - 1, (const xedge_t*)gf.x) < 0)
+      error("cannot load the graph");
+    phase_report(stderr, "build", timebase_sec() - begin);
+
+    begin = timebase_sec();
+    f = solver_solve(sv);
+    phase_report(stderr, "solve", timebase_sec() - begin);
+
+    if (i == 0) allocs = solver_allocs(sv);
+  }
+
+  if (bisect)
+    search(sv, &gf, f, nthread);
+  else if (query)
+    railway(sv, &gf, f);
+  else
+    printf("f = %d\n", f);
+
+  fprintf(stderr, "allocations = %ld, %ld after the first run\n",
+          solver_allocs(sv), solver_allocs(sv) - allocs);
+
+  begin = timebase_sec();
+  solver_free(sv);
+  graphfile_free(&gf);
+  input_close(&in);
+  phase_report(stderr, "teardown", timebase_sec() - begin);
+
+  return 0;
+}
@@ -0,0 +1,572 @@
+#include "solver.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* sequential push-relabel on arc arrays: FIFO selection, a
+ * current arc per node, exact relabels, gaps and a global relabel
+ * after the initial push and whenever enough work has been done
+ * since the previous one. see sequential.c for ALPHA and BETA.
+ *
+ */
+
+#define ALPHA 6
+#define BETA 12
+
+typedef struct arc_t arc_t;
+
+/* each edge becomes two arcs, one in the adjacency of each of its
+ * nodes. the arcs of node u are arc[off[u]] up to but not
+ * including arc[off[u + 1]], and edge i has its arc out of u in
+ * slot at[2i] and the one out of v in at[2i + 1].
+ *
+ */
+
+struct arc_t {
+  int v;   /* node the arc points to.	*/
+  int r;   /* residual capacity.		*/
+  int rev; /* index of the reverse arc.	*/
+};
+
+struct solver_t {
+  int n;        /* nodes.			*/
+  int m;        /* edges.			*/
+  int s;        /* source.			*/
+  int t;        /* sink.			*/
+  int nmax;     /* nodes there is room for.	*/
+  int mmax;     /* edges there is room for.	*/
+  xedge_t* e;   /* m edges as loaded.		*/
+  int* off;     /* n + 1 arc offsets.		*/
+  int* at;      /* 2m arc slots of the edges.	*/
+  arc_t* arc;   /* 2m arcs.			*/
+  int* h;       /* n heights.			*/
+  int* x;       /* n excesses.			*/
+  int* cur;     /* n current arcs.		*/
+  int* count;   /* nodes at each height < 2n.	*/
+  int* queue;   /* n active nodes, a ring.	*/
+  int* list;    /* n for global relabel.		*/
+  int* pred;    /* n arcs of augmenting paths.	*/
+  int head;     /* of queue.			*/
+  int size;     /* nodes in queue.		*/
+  long work;    /* since last global relabel.	*/
+  int f;        /* flow from s to t.		*/
+  long allocs;  /* allocations and growths.	*/
+  int shared;   /* e, off and at are not ours.	*/
+};
+
+static int resize(void* p, size_t size) {
+  void* q;
+
+  /* p points to the pointer, which is left alone if it fails. */
+
+  q = realloc(*(void**)p, size);
+
+  if (q == NULL) return -1;
+
+  *(void**)p = q;
+
+  return 0;
+}
+
+static int grow(solver_t* sv, int n, int m) {
+  size_t k;
+
+  if (n > sv->nmax) {
+    k = n;
+
+    if (resize(&sv->off, (k + 1) * sizeof(int)) < 0 ||
+        resize(&sv->h, k * sizeof(int)) < 0 ||
+        resize(&sv->x, k * sizeof(int)) < 0 ||
+        resize(&sv->cur, k * sizeof(int)) < 0 ||
+        resize(&sv->count, (2 * k + 1) * sizeof(int)) < 0 ||
+        resize(&sv->queue, k * sizeof(int)) < 0 ||
+        resize(&sv->list, k * sizeof(int)) < 0 ||
+        resize(&sv->pred, k * sizeof(int)) < 0)
+      return -1;
+
+    sv->nmax = n;
+    sv->allocs += 1;
+  }
+
+  if (m > sv->mmax) {
+    k = m;
+
+    if (resize(&sv->e, k * sizeof(xedge_t)) < 0 ||
+        resize(&sv->at, 2 * k * sizeof(int)) < 0 ||
+        resize(&sv->arc, 2 * k * sizeof(arc_t)) < 0)
+      return -1;
+
+    sv->mmax = m;
+    sv->allocs += 1;
+  }
+
+  return 0;
+}
+
+solver_t* solver_new(int n, int m) {
+  solver_t* sv;
+
+  sv = calloc(1, sizeof(solver_t));
+
+  if (sv == NULL) return NULL;
+
+  if (grow(sv, n > 0 ? n : 1, m > 0 ? m : 1) < 0) {
+    solver_free(sv);
+    return NULL;
+  }
+
+  return sv;
+}
+
+solver_t* solver_share(const solver_t* sv) {
+  solver_t* sh;
+  size_t n;
+  size_t m;
+
+  /* the arcs hold the residual capacities so they are copied but
+   * the edges and where their arcs are stay with sv.
+   *
+   */
+
+  if ((sh = calloc(1, sizeof(solver_t))) == NULL) return NULL;
+
+  n = sv->n;
+  m = sv->m > 0 ? sv->m : 1;
+
+  sh->n = sh->nmax = sv->n;
+  sh->m = sv->m;
+  sh->mmax = m;
+  sh->s = sv->s;
+  sh->t = sv->t;
+  sh->e = sv->e;
+  sh->off = sv->off;
+  sh->at = sv->at;
+  sh->shared = 1;
+  sh->allocs = 1;
+
+  sh->arc = malloc(2 * m * sizeof(arc_t));
+  sh->h = malloc(n * sizeof(int));
+  sh->x = malloc(n * sizeof(int));
+  sh->cur = malloc(n * sizeof(int));
+  sh->count = malloc((2 * n + 1) * sizeof(int));
+  sh->queue = malloc(n * sizeof(int));
+  sh->list = malloc(n * sizeof(int));
+  sh->pred = malloc(n * sizeof(int));
+
+  if (sh->arc == NULL || sh->h == NULL || sh->x == NULL || sh->cur == NULL ||
+      sh->count == NULL || sh->queue == NULL || sh->list == NULL ||
+      sh->pred == NULL) {
+    solver_free(sh);
+    return NULL;
+  }
+
+  memcpy(sh->arc, sv->arc, 2 * sv->m * sizeof(arc_t));
+
+  return sh;
+}
+
+void solver_free(solver_t* sv) {
+  if (sv == NULL) return;
+
+  if (!sv->shared) {
+    free(sv->e);
+    free(sv->off);
+    free(sv->at);
+  }
+
+  free(sv->arc);
+  free(sv->h);
+  free(sv->x);
+  free(sv->cur);
+  free(sv->count);
+  free(sv->queue);
+  free(sv->list);
+  free(sv->pred);
+  free(sv);
+}
+
+int solver_load(solver_t* sv, int n, int m, int s, int t, const xedge_t* e) {
+  int* off;
+  int* cur;
+  int i;
+  int j;
+  int k;
+
+  if (sv->shared || n < 2 || m < 0 || s < 0 || s >= n || t < 0 || t >= n ||
+      s == t)
+    return -1;
+
+  for (i = 0; i < m; i += 1)
+    if (e[i].u < 0 || e[i].u >= n || e[i].v < 0 || e[i].v >= n) return -1;
+
+  if (grow(sv, n, m) < 0) return -1;
+
+  sv->n = n;
+  sv->m = m;
+  sv->s = s;
+  sv->t = t;
+  memcpy(sv->e, e, m * sizeof(xedge_t));
+
+  /* count the arcs of each node, then give each edge the next
+   * free slot at both of its nodes, with cur as the next slot.
+   *
+   */
+
+  off = sv->off;
+  cur = sv->cur;
+  memset(off, 0, (n + 1) * sizeof(int));
+
+  for (i = 0; i < m; i += 1) {
+    off[e[i].u + 1] += 1;
+    off[e[i].v + 1] += 1;
+  }
+
+  for (i = 0; i < n; i += 1) off[i + 1] += off[i];
+
+  memcpy(cur, off, n * sizeof(int));
+
+  for (i = 0; i < m; i += 1) {
+    j = sv->at[2 * i] = cur[e[i].u]++;
+    k = sv->at[2 * i + 1] = cur[e[i].v]++;
+    sv->arc[j].v = e[i].v;
+    sv->arc[j].rev = k;
+    sv->arc[k].v = e[i].u;
+    sv->arc[k].rev = j;
+  }
+
+  return 0;
+}
+
+void solver_capacity(solver_t* sv, int i, int c) { sv->e[i].c = c; }
+
+static void enqueue(solver_t* sv, int u) {
+  sv->queue[(sv->head + sv->size) % sv->n] = u;
+  sv->size += 1;
+}
+
+static int dequeue(solver_t* sv) {
+  int u;
+
+  u = sv->queue[sv->head];
+  sv->head = (sv->head + 1) % sv->n;
+  sv->size -= 1;
+
+  return u;
+}
+
+static void push(solver_t* sv, int u, int a, int d) {
+  arc_t* arc;
+  int v;
+
+  arc = &sv->arc[a];
+  v = arc->v;
+  arc->r -= d;
+  sv->arc[arc->rev].r += d;
+  sv->x[u] -= d;
+  sv->x[v] += d;
+
+  /* v had no excess before so it is not in the queue. */
+
+  if (sv->x[v] == d && v != sv->s && v != sv->t) enqueue(sv, v);
+}
+
+static int bfs(solver_t* sv, int r, int tail) {
+  arc_t* arc;
+  int head;
+  int u;
+  int v;
+  int a;
+
+  /* give the nodes that reach r over residual arcs and have no
+   * height yet their distance to r added to its height.
+   *
+   */
+
+  head = tail;
+  sv->list[tail++] = r;
+
+  while (head < tail) {
+    v = sv->list[head++];
+
+    for (a = sv->off[v]; a < sv->off[v + 1]; a += 1) {
+      arc = &sv->arc[a];
+      u = arc->v;
+
+      if (sv->h[u] == 2 * sv->n && sv->arc[arc->rev].r > 0) {
+        sv->h[u] = sv->h[v] + 1;
+        sv->list[tail++] = u;
+      }
+    }
+  }
+
+  return tail;
+}
+
+static void global_relabel(solver_t* sv) {
+  int tail;
+  int u;
+
+  /* set every height to the exact residual distance to t, or for
+   * nodes that cannot reach t to n plus that to s. excess that
+   * has to go back to s then does not climb from n again after
+   * every global relabel. nodes that reach neither have no excess
+   * and only arcs to each other, so any height will do.
+   *
+   */
+
+  for (u = 0; u < sv->n; u += 1) sv->h[u] = 2 * sv->n;
+
+  sv->h[sv->t] = 0;
+  sv->h[sv->s] = sv->n;
+  tail = bfs(sv, sv->t, 0);
+  bfs(sv, sv->s, tail);
+
+  memset(sv->count, 0, (2 * sv->n + 1) * sizeof(int));
+
+  for (u = 0; u < sv->n; u += 1) {
+    if (sv->h[u] == 2 * sv->n) sv->h[u] = sv->n;
+    if (u != sv->s) sv->count[sv->h[u]] += 1;
+    sv->cur[u] = sv->off[u];
+  }
+
+  sv->work = 0;
+}
+
+static void gap(solver_t* sv, int k) {
+  int u;
+
+  /* no node has height k so none above it can reach t. */
+
+  for (u = 0; u < sv->n; u += 1) {
+    if (u != sv->s && sv->h[u] > k && sv->h[u] < sv->n) {
+      sv->count[sv->h[u]] -= 1;
+      sv->count[sv->n] += 1;
+      sv->h[u] = sv->n;
+      sv->cur[u] = sv->off[u];
+    }
+  }
+}
+
+static void relabel(solver_t* sv, int u) {
+  arc_t* arc;
+  int min;
+  int old;
+  int a;
+
+  /* just above the lowest neighbour over a residual arc. there
+   * is one since the excess of u came over some arc.
+   *
+   */
+
+  min = 2 * sv->n;
+
+  for (a = sv->off[u]; a < sv->off[u + 1]; a += 1) {
+    arc = &sv->arc[a];
+    if (arc->r > 0 && arc->v != u && sv->h[arc->v] < min)
+      min = sv->h[arc->v];
+  }
+
+  old = sv->h[u];
+  sv->h[u] = min + 1;
+  sv->count[old] -= 1;
+  sv->count[min + 1] += 1;
+  sv->cur[u] = sv->off[u];
+  sv->work += BETA + sv->off[u + 1] - sv->off[u];
+
+  if (sv->count[old] == 0 && old < sv->n) gap(sv, old);
+}
+
+static void discharge(solver_t* sv, int u) {
+  arc_t* arc;
+  int end;
+  int a;
+
+  end = sv->off[u + 1];
+
+  while (sv->x[u] > 0) {
+    for (a = sv->cur[u]; a < end; a += 1) {
+      arc = &sv->arc[a];
+      sv->work += 1;
+
+      if (arc->r > 0 && sv->h[u] == sv->h[arc->v] + 1) {
+        push(sv, u, a, sv->x[u] < arc->r ? sv->x[u] : arc->r);
+
+        /* the arc may have capacity left for the next time. */
+
+        if (sv->x[u] == 0) break;
+      }
+    }
+
+    sv->cur[u] = a;
+
+    if (sv->x[u] > 0) relabel(sv, u);
+  }
+}
+
+int solver_solve(solver_t* sv) { return solver_solve_without(sv, NULL, 0); }
+
+int solver_solve_without(solver_t* sv, const int* del, int k) {
+  arc_t* arc;
+  int s;
+  int i;
+  int a;
+
+  /* start from zero flow with the capacities as they are now,
+   * except for the edges in del which have none.
+   *
+   */
+
+  for (i = 0; i < sv->m; i += 1) {
+    sv->arc[sv->at[2 * i]].r = sv->e[i].c;
+    sv->arc[sv->at[2 * i + 1]].r = sv->e[i].c;
+  }
+
+  for (i = 0; i < k; i += 1) {
+    sv->arc[sv->at[2 * del[i]]].r = 0;
+    sv->arc[sv->at[2 * del[i] + 1]].r = 0;
+  }
+
+  memset(sv->x, 0, sv->n * sizeof(int));
+  sv->head = 0;
+  sv->size = 0;
+
+  s = sv->s;
+
+  for (a = sv->off[s]; a < sv->off[s + 1]; a += 1) {
+    arc = &sv->arc[a];
+    if (arc->r > 0 && arc->v != s) {
+      sv->x[s] += arc->r;
+      push(sv, s, a, arc->r);
+    }
+  }
+
+  global_relabel(sv);
+
+  while (sv->size > 0) {
+    discharge(sv, dequeue(sv));
+
+    if (sv->work > ALPHA * sv->n + sv->m) global_relabel(sv);
+  }
+
+  sv->f = sv->x[sv->t];
+
+  return sv->f;
+}
+
+int solver_flow(solver_t* sv, int i) {
+  return sv->e[i].c - sv->arc[sv->at[2 * i]].r;
+}
+
+static int path(solver_t* sv, int a, int b) {
+  arc_t* arc;
+  int head;
+  int tail;
+  int u;
+  int i;
+
+  /* breadth first search from a to b over residual arcs that
+   * leaves the arc into each node reached in pred. returns the
+   * least residual capacity on the path, or 0 if there is none.
+   *
+   */
+
+  for (u = 0; u < sv->n; u += 1) sv->pred[u] = -1;
+
+  sv->list[0] = a;
+  head = 0;
+  tail = 1;
+
+  while (head < tail && sv->pred[b] < 0) {
+    u = sv->list[head++];
+
+    for (i = sv->off[u]; i < sv->off[u + 1]; i += 1) {
+      arc = &sv->arc[i];
+      if (arc->r > 0 && arc->v != a && sv->pred[arc->v] < 0) {
+        sv->pred[arc->v] = i;
+        sv->list[tail++] = arc->v;
+      }
+    }
+  }
+
+  if (sv->pred[b] < 0) return 0;
+
+  for (i = INT_MAX, u = b; u != a; u = sv->arc[sv->arc[sv->pred[u]].rev].v)
+    if (sv->arc[sv->pred[u]].r < i) i = sv->arc[sv->pred[u]].r;
+
+  return i;
+}
+
+static int augment(solver_t* sv, int a, int b, int want) {
+  arc_t* arc;
+  int sent;
+  int d;
+  int u;
+
+  /* send up to want from a to b along shortest residual paths. */
+
+  if (a == b) return want;
+
+  for (sent = 0; sent < want && (d = path(sv, a, b)) > 0; sent += d) {
+    if (d > want - sent) d = want - sent;
+
+    for (u = b; u != a; u = sv->arc[arc->rev].v) {
+      arc = &sv->arc[sv->pred[u]];
+      arc->r -= d;
+      sv->arc[arc->rev].r += d;
+    }
+  }
+
+  return sent;
+}
+
+int solver_remove(solver_t* sv, int i) {
+  int fl;
+  int a;
+  int b;
+  int d;
+
+  /* the flow over edge i leaves excess at its tail a and a
+   * deficit at its head b. first try to route it from a to b
+   * another way. what cannot be is sent back from a to s and
+   * taken back from t to b, which is always possible since it
+   * came from s and went on to t. the flow is then valid but
+   * maybe not maximum, so look for more from s to t.
+   *
+   */
+
+  fl = solver_flow(sv, i);
+
+  if (fl >= 0) {
+    a = sv->e[i].u;
+    b = sv->e[i].v;
+  } else {
+    a = sv->e[i].v;
+    b = sv->e[i].u;
+    fl = -fl;
+  }
+
+  sv->e[i].c = 0;
+  sv->arc[sv->at[2 * i]].r = 0;
+  sv->arc[sv->at[2 * i + 1]].r = 0;
+
+  d = fl - augment(sv, a, b, fl);
+
+  if (d > 0) {
+    augment(sv, a, sv->s, d);
+    augment(sv, sv->t, b, d);
+    sv->f -= d;
+    sv->f += augment(sv, sv->s, sv->t, INT_MAX);
+  }
+
+  return sv->f;
+}
+
+void solver_reset(solver_t* sv) {
+  if (sv->shared) return;
+
+  sv->n = 0;
+  sv->m = 0;
+}
+
+long solver_allocs(solver_t* sv) { return sv->allocs; }
@@ -0,0 +1,91 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdint.h>
+
+/* a maximum flow solver that is created once and then used for
+ * many graphs. all storage is kept between graphs and only grows
+ * when a graph has more nodes or edges than any before it, so
+ * solving graphs of about the same size again allocates nothing.
+ *
+ * edges are undirected: edge i can carry up to c in either
+ * direction between u and v. a solver is not safe to use from
+ * two threads at once but different solvers are independent.
+ *
+ * build libpreflow.a and libpreflow.so with make lib.
+ *
+ */
+
+typedef struct xedge_t xedge_t;
+typedef struct solver_t solver_t;
+
+struct xedge_t {
+  int32_t u; /* one of the two nodes.	*/
+  int32_t v; /* the other. 			*/
+  int32_t c; /* capacity.			*/
+};
+
+/* a solver with room for n nodes and m edges, or NULL if out of
+ * memory. the sizes are only a hint.
+ *
+ */
+
+solver_t* solver_new(int n, int m);
+void solver_free(solver_t* sv);
+
+/* replace the graph with n nodes, source s, sink t and the m
+ * edges in e, which is copied. returns 0, or -1 if a node is out
+ * of range or the storage could not grow.
+ *
+ */
+
+int solver_load(solver_t* sv, int n, int m, int s, int t, const xedge_t* e);
+
+/* a solver for the graph loaded into sv that only has its own
+ * residual capacities, heights and queues, so that several can
+ * solve the same graph at once from different threads. the edges
+ * are shared and only read, so sv must not load another graph,
+ * change a capacity or remove an edge, nor be freed, while any of
+ * its shares are in use. a share can only solve.
+ *
+ */
+
+solver_t* solver_share(const solver_t* sv);
+
+/* set the capacity of edge i of the loaded graph. */
+
+void solver_capacity(solver_t* sv, int i, int c);
+
+/* the maximum flow from s to t, always found from zero flow. */
+
+int solver_solve(solver_t* sv);
+
+/* the same but as if the k edges in del had no capacity. the
+ * edges themselves are left alone.
+ *
+ */
+
+int solver_solve_without(solver_t* sv, const int* del, int k);
+
+/* flow on edge i after solver_solve, > 0 if from u to v. */
+
+int solver_flow(solver_t* sv, int i);
+
+/* remove edge i after solver_solve and return the new maximum
+ * flow. only the flow that went over the edge is moved, so a
+ * sequence of removals costs much less than solving again after
+ * each.
+ *
+ */
+
+int solver_remove(solver_t* sv, int i);
+
+/* forget the graph but keep the storage. */
+
+void solver_reset(solver_t* sv);
+
+/* times the storage was allocated or grown. */
+
+long solver_allocs(solver_t* sv);
+
+#endif /* SOLVER_H */
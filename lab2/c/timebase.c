@@ -0,0 +1,114 @@
+#include "timebase.h"
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define TSC 1
+#elif defined(__powerpc__) || defined(__powerpc64__)
+#define TB 1
+#endif
+
+#define CALIBRATE 0.005 /* seconds spent calibrating.	*/
+
+static int counter; /* reading a hardware counter.	*/
+static double tick; /* seconds per tick, 0 before init.	*/
+static uint64_t start;
+
+static uint64_t clock_ns() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int invariant_tsc() {
+#if TSC
+  unsigned a, b, c, d;
+
+  /* constant and non-stop rate, in edx of leaf 0x80000007. */
+
+  if (__get_cpuid(0x80000000, &a, &b, &c, &d) == 0 || a < 0x80000007)
+    return 0;
+
+  __get_cpuid(0x80000007, &a, &b, &c, &d);
+
+  return (d >> 8) & 1;
+#else
+  return 0;
+#endif
+}
+
+uint64_t timebase_ticks() {
+  if (counter) {
+#if TSC
+    /* no earlier load may still be in flight when it is read. */
+
+    _mm_lfence();
+    return __rdtsc();
+#elif TB
+    return __builtin_ppc_get_timebase();
+#endif
+  }
+
+  return clock_ns();
+}
+
+void init_timebase() {
+  uint64_t t0;
+  uint64_t t1;
+  uint64_t c0;
+  uint64_t c1;
+
+#if TSC
+  counter = invariant_tsc();
+#elif TB
+  counter = 1;
+#endif
+
+  if (counter) {
+    t0 = clock_ns();
+    c0 = timebase_ticks();
+
+    do
+      t1 = clock_ns();
+    while (t1 - t0 < CALIBRATE * 1e9);
+
+    c1 = timebase_ticks();
+    tick = (t1 - t0) * 1e-9 / (c1 - c0);
+  } else {
+    tick = 1e-9;
+  }
+
+  start = timebase_ticks();
+}
+
+double timebase_sec() {
+  if (tick == 0) init_timebase();
+
+  return (timebase_ticks() - start) * tick;
+}
+
+double timebase_tick() {
+  if (tick == 0) init_timebase();
+
+  return tick;
+}
+
+const char* timebase_source() {
+  if (tick == 0) init_timebase();
+
+#if TSC
+  if (counter) return "tsc";
+#elif TB
+  if (counter) return "tb";
+#endif
+
+  return "clock";
+}
+
+void phase_report(FILE* f, const char* name, double sec) {
+  fprintf(f, "phase %s = %.9f s\n", name, sec);
+}
@@ -0,0 +1,34 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* a clock for timing short phases. on x86 it reads the time stamp
+ * counter when the cpu says it runs at a constant rate, on Power
+ * the timebase register, and otherwise CLOCK_MONOTONIC. counters
+ * are calibrated against CLOCK_MONOTONIC by init_timebase, which
+ * timebase_sec also calls the first time if needed.
+ *
+ */
+
+void init_timebase(void);
+
+/* seconds since init_timebase. */
+
+double timebase_sec(void);
+
+/* raw counter and its period in seconds. */
+
+uint64_t timebase_ticks(void);
+double timebase_tick(void);
+
+/* "tsc", "tb" or "clock". */
+
+const char* timebase_source(void);
+
+/* print "phase name = seconds s" on f, which is what bench reads. */
+
+void phase_report(FILE* f, const char* name, double sec);
+
+#endif /* TIMEBASE_H */
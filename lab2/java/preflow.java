@@ -10,6 +10,7 @@ class Node {
 	int	h;
 	int	e;
 	int	i;
+	int	cur;		// current arc in adj
 	Node	next;
 	LinkedList<Edge>	adj;
 	ReentrantLock mutex;
@@ -21,8 +22,9 @@ class Node {
 		mutex = new ReentrantLock();
 	}
 
-	public void relabel() {
-		this.h += 1;
+	public void relabel(int min) {
+		this.h = min + 1;
+		this.cur = 0;
 	}
 }
 
@@ -79,6 +81,29 @@ class Work extends Thread {
 		}
 	}
 
+	// lowest neighbour with residual capacity over the first end
+	// arcs, or min if none is lower
+	int lowest(int min, int end) {
+		ListIterator<Edge> iter = excess.adj.listIterator();
+		Edge edg;
+		Node nei;
+
+		for (int i = 0; i < end; i += 1) {
+			edg = iter.next();
+			nei = edg.other(excess);
+
+			lock_in_order(excess, nei);
+
+			if (edg.available(edg.direction(excess)) > 0 && nei.h < min)
+				min = nei.h;
+
+			excess.mutex.unlock();
+			nei.mutex.unlock();
+		}
+
+		return min;
+	}
+
 	public void run() {
 		ListIterator<Edge> iter;
 		Edge edg = null;
@@ -87,13 +112,22 @@ class Work extends Thread {
 		int  dir = 1;
 		int  flo = 0;
 		int  ava = 0;
+		int  min;
+		int  start;
+		int  i;
+		boolean done;
 
 		// Excess is a node with excess preflow
 		while (excess != null) {
-			iter = excess.adj.listIterator();
-
-			// For every adjecent edge
-			while (iter.hasNext()) {
+			// arcs before the current one cannot be admissible
+			// until excess gets a new height, so start there and
+			// push along every admissible arc while excess remains
+			start = excess.cur;
+			min = Integer.MAX_VALUE;
+			done = false;
+			iter = excess.adj.listIterator(start);
+
+			for (i = start; iter.hasNext(); i += 1) {
 				// Non-changing properties
 				edg = iter.next();
 				nei = edg.other(excess);
@@ -101,39 +135,45 @@ class Work extends Thread {
 
 				// Lock both nodes in right order
 				lock_in_order(excess, nei);
-				
+
 				ava = edg.available(dir);
-				flo = Math.min(excess.e, ava);
 
 				if (excess.h > nei.h && ava > 0) {
-					break;
-				} else {
-					excess.mutex.unlock();
-					nei.mutex.unlock();
-					nei = null;
+					flo = Math.min(excess.e, ava);
+					excess.e -= flo;
+					nei.e += flo;
+					edg.f += dir * flo;
+
+					if (nei.e == flo) {
+						g.enter_excess(nei);
+					}
+				} else if (ava > 0 && nei.h < min) {
+					min = nei.h;
 				}
-			}
 
-			// if nei != null, we broke the while loop
-			// and still have both locks => push => unlock
-			
-			// push or relabel
-			if (nei != null) {
-				excess.e -= flo;
-				nei.e += flo;
-				edg.f += dir * flo;
-
-				if (nei.e == flo) {
-					g.enter_excess(nei);
-				}
-				
+				// stay on an arc that still has capacity
+				done = excess.e == 0;
+
+				excess.mutex.unlock();
 				nei.mutex.unlock();
-			} else {
-				excess.mutex.lock();
-				excess.h += 1;
+
+				if (done)
+					break;
 			}
 
-			// either case above, we have excess lock
+			excess.cur = i;
+
+			// no arc left, relabel to just above the lowest
+			// neighbour, since heights only grow those seen
+			// above can only be higher now
+			if (!done)
+				min = lowest(min, start);
+
+			excess.mutex.lock();
+
+			if (!done && min < Integer.MAX_VALUE)
+				excess.relabel(min);
+
 			if (excess.e == 0) {
 				excess.mutex.unlock();
 				excess = g.leave_excess();
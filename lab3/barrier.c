@@ -0,0 +1,125 @@
+#include "barrier.h"
+
+#include <limits.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define SPIN 20000 /* default spins before blocking.	*/
+
+static void set_spin(barrier_t* b) {
+  b->yield = b->cpus > 0 && b->n > b->cpus;
+  b->spin = b->policy == BARRIER_BLOCK || b->yield ? 0 : SPIN;
+}
+
+static void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+/* without futexes blocking degrades to yielding the processor. */
+
+static void futex_wait(atomic_int* addr, int val) {
+#ifdef __linux__
+  syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+#else
+  if (atomic_load(addr) == val) sched_yield();
+#endif
+}
+
+static void futex_wake(atomic_int* addr) {
+#ifdef __linux__
+  syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+  (void)addr;
+#endif
+}
+
+void barrier_init(barrier_t* b, int n, int policy) {
+  atomic_init(&b->count, n);
+  atomic_init(&b->sum, 0);
+  atomic_init(&b->episode, 0);
+  atomic_init(&b->sleepers, 0);
+  atomic_init(&b->result, 0);
+  b->n = n;
+  b->policy = policy;
+  b->cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  set_spin(b);
+}
+
+void barrier_destroy(barrier_t* b) { (void)b; }
+
+long barrier_sum(barrier_t* b, long x) {
+  int episode;
+  int i;
+
+  /* the episode cannot end before this thread has arrived, so
+   * reading it first tells which value to wait for.
+   *
+   */
+
+  episode = atomic_load_explicit(&b->episode, memory_order_relaxed);
+
+  if (x != 0) atomic_fetch_add(&b->sum, x);
+
+  if (atomic_fetch_sub(&b->count, 1) == 1) {
+    /* last to arrive: publish the sum, reset and release. */
+
+    x = atomic_exchange(&b->sum, 0);
+    atomic_store(&b->result, x);
+    atomic_store(&b->count, b->n);
+    atomic_store(&b->episode, episode + 1);
+
+    if (b->policy != BARRIER_SPIN && atomic_load(&b->sleepers) > 0)
+      futex_wake(&b->episode);
+
+    return x;
+  }
+
+  for (i = 0; b->policy == BARRIER_SPIN || i < b->spin; i += 1) {
+    if (atomic_load_explicit(&b->episode, memory_order_acquire) != episode)
+      return atomic_load(&b->result);
+
+    if (b->yield)
+      sched_yield();
+    else
+      cpu_relax();
+  }
+
+  /* a waker that saw no sleepers ended the episode before the
+   * increment below, so the futex sees the new value and returns.
+   *
+   */
+
+  atomic_fetch_add(&b->sleepers, 1);
+
+  while (atomic_load(&b->episode) == episode)
+    futex_wait(&b->episode, episode);
+
+  atomic_fetch_sub(&b->sleepers, 1);
+
+  return atomic_load(&b->result);
+}
+
+void barrier_wait(barrier_t* b) { barrier_sum(b, 0); }
+
+void barrier_resize(barrier_t* b, int n) {
+  b->n = n;
+  set_spin(b);
+  atomic_store(&b->count, n);
+}
+
+int barrier_policy(const char* name) {
+  if (strcmp(name, "spin") == 0) return BARRIER_SPIN;
+  if (strcmp(name, "hybrid") == 0) return BARRIER_HYBRID;
+  if (strcmp(name, "block") == 0) return BARRIER_BLOCK;
+  return -1;
+}
@@ -0,0 +1,59 @@
+#ifndef BARRIER_H
+#define BARRIER_H
+
+#include <stdatomic.h>
+
+/* a barrier for the lab3 rounds. a waiting thread either spins on
+ * the episode number, sleeps on it with a futex, or spins for a
+ * while and then sleeps. counting episodes instead of flipping a
+ * sense bit lets a released thread be slow to notice even when
+ * fewer threads have gone on to later episodes.
+ *
+ * with more threads than online processors a spinning thread only
+ * keeps the last one from arriving, so then the hybrid policy
+ * blocks at once and the spin policy yields as it spins.
+ *
+ */
+
+#define BARRIER_SPIN 0  /* spin until released.		*/
+#define BARRIER_HYBRID 1 /* spin, then block.		*/
+#define BARRIER_BLOCK 2 /* block at once.		*/
+
+typedef struct barrier_t barrier_t;
+
+struct barrier_t {
+  _Alignas(64) atomic_int count; /* threads still to arrive.	*/
+  atomic_long sum;               /* of the values passed in.	*/
+  _Alignas(64) atomic_int episode; /* ends when all have arrived. */
+  atomic_int sleepers;           /* threads in futex wait.	*/
+  atomic_long result;            /* sum of the last episode.	*/
+  int n;                         /* number of threads.		*/
+  int policy;
+  int spin; /* iterations before blocking.	*/
+  int cpus; /* online processors.		*/
+  int yield; /* more threads than processors.	*/
+};
+
+void barrier_init(barrier_t* b, int n, int policy);
+void barrier_destroy(barrier_t* b);
+
+/* wait for all n threads and return the sum of the x they passed.
+ * a thread that is not at the next episode may see the sum of a
+ * later one if it is slow to return.
+ *
+ */
+
+long barrier_sum(barrier_t* b, long x);
+
+void barrier_wait(barrier_t* b);
+
+/* change the number of threads the next episode waits for. no
+ * thread may be waiting at b or arrive at it during the call.
+ *
+ */
+
+void barrier_resize(barrier_t* b, int n);
+
+int barrier_policy(const char* name);
+
+#endif /* BARRIER_H */
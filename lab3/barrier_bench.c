@@ -0,0 +1,113 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "barrier.h"
+#include "pthread_barrier.h"
+
+/* measures the round-trip latency of the barriers used by the
+ * lab3 rounds: every thread waits at the same barrier a number of
+ * times and the time per episode is reported for each policy and
+ * for pthread_barrier_wait.
+ *
+ */
+
+#define ROUNDS 100000
+
+typedef struct bench_args bench_args;
+
+struct bench_args {
+  barrier_t* b;
+  pthread_barrier_t* pb;
+  int rounds;
+};
+
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void* run(void* arg) {
+  bench_args* args = arg;
+  int i;
+
+  for (i = 0; i < args->rounds; i += 1)
+    if (args->b != NULL)
+      barrier_wait(args->b);
+    else
+      pthread_barrier_wait(args->pb);
+
+  return 0;
+}
+
+static double bench(int nthread, int policy, int rounds) {
+  pthread_t thread[nthread];
+  pthread_barrier_t pb;
+  barrier_t b;
+  bench_args args;
+  double begin;
+  double end;
+  int i;
+
+  args.rounds = rounds;
+
+  if (policy < 0) {
+    pthread_barrier_init(&pb, NULL, nthread);
+    args.b = NULL;
+    args.pb = &pb;
+  } else {
+    barrier_init(&b, nthread, policy);
+    args.b = &b;
+    args.pb = NULL;
+  }
+
+  begin = now();
+
+  for (i = 1; i < nthread; i += 1)
+    if (pthread_create(&thread[i], NULL, run, &args) != 0) {
+      fprintf(stderr, "pthread_create failed\n");
+      exit(1);
+    }
+
+  run(&args);
+
+  for (i = 1; i < nthread; i += 1) pthread_join(thread[i], NULL);
+
+  end = now();
+
+  if (policy < 0)
+    pthread_barrier_destroy(&pb);
+  else
+    barrier_destroy(&b);
+
+  return (end - begin) / rounds * 1e9;
+}
+
+int main(int argc, char* argv[]) {
+  int max;
+  int rounds;
+  int n;
+  int p;
+
+  max = argc > 1 ? atoi(argv[1]) : 8;
+  rounds = argc > 2 ? atoi(argv[2]) : ROUNDS;
+
+  printf("%8s %12s %12s %12s %12s\n", "threads", "spin", "hybrid", "block",
+         "pthread");
+
+  for (n = 1; n <= max; n *= 2) {
+    printf("%8d", n);
+
+    for (p = 0; p < 3; p += 1) {
+      printf(" %9.0f ns", bench(n, p, rounds));
+      fflush(stdout);
+    }
+
+    printf(" %9.0f ns\n", bench(n, -1, rounds));
+  }
+
+  return 0;
+}
@@ -1,12 +1,22 @@
 #include <assert.h>
-#include <ctype.h>
+#include <limits.h>
 #include <pthread.h>
+#include <sched.h>
 #include <stdarg.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-#include "pthread_barrier.h"
+#include "barrier.h"
+#include "build.h"
+#include "counter.h"
+#include "flow.h"
+#include "graphfile.h"
+#include "input.h"
+#include "timebase.h"
 
 #define PRINT 0 /* enable/disable prints. */
 
@@ -28,62 +38,141 @@
 #endif
 
 #define MIN(a, b) (((a) <= (b)) ? (a) : (b))
+#define MAX(a, b) (((a) >= (b)) ? (a) : (b))
+
+/* workers are woken for a round only if each gets about SLICE
+ * seconds of work, judged from the nodes that may become active
+ * and the cost per node of the recent rounds.
+ *
+ */
+
+#define SLICE 50e-6
 
 typedef struct graph_t graph_t;
 typedef struct node_t node_t;
-typedef struct edge_t edge_t;
-typedef struct list_t list_t;
+typedef struct arc_t arc_t;
 typedef struct work_args work_args;
 typedef struct action_t action_t;
+typedef struct actions_t actions_t;
+typedef struct deque_t deque_t;
+typedef struct edges_t edges_t;
 
 struct action_t {
-  node_t* node;   /* node to act on */
-  int relabel;    /* relabel or push */
-  int flo;        /* if push, flow amount */
-  int dir;        /* if push, direction */
-  edge_t* edge;   /* if push, edge */
-  action_t* next; /* next in list */
+  int node; /* node to act on */
+  int arc;  /* if push, index of arc, else -1 - new height */
+  flow_t flo; /* if push, flow amount */
+};
+
+/* the actions one worker queued this round for the nodes owned
+ * by one other worker (or itself). the array is kept between
+ * rounds and only grows, so after the first few rounds queueing
+ * an action is a store and the owner reads them back with one
+ * sequential scan.
+ *
+ */
+
+struct actions_t {
+  _Alignas(64) action_t* a;
+  int n;       /* queued this round.		*/
+  int size;    /* allocated.			*/
+  long allocs; /* number of times a was grown.	*/
 };
 
 struct work_args {
   graph_t* g;
-  pthread_barrier_t* bar1;
-  pthread_barrier_t* bar2;
+  barrier_t* bar1;
+  barrier_t* bar2;
   int i;
+  int nodes;    /* discharged this round.	*/
+  int steals;   /* taken from others this round.	*/
+  long actions; /* applied in total.		*/
+  long cross;   /* of those, queued by another.	*/
+  int queued;   /* actions queued this round.	*/
+  double busy;  /* seconds discharging this round. */
+  int parks;    /* times this worker was parked.	*/
+  counters_t k; /* with -DCOUNT=1.		*/
 };
 
-struct list_t {
-  edge_t* edge;
-  list_t* next;
+/* active nodes of one worker as a Chase-Lev work-stealing deque.
+ * the owner takes from the bottom and idle workers steal from the
+ * top. a node is active at most once per round so n slots are
+ * enough. the owner refills its deque between the barriers, when
+ * no one steals.
+ *
+ */
+
+struct deque_t {
+  _Alignas(64) atomic_long top;
+  _Alignas(64) atomic_long bottom;
+  _Atomic(node_t*)* buf;
+  long size;
 };
 
 struct node_t {
-  int h;        /* height.			*/
-  int e;        /* excess flow.			*/
-  list_t* edge; /* adjacency list.		*/
-  node_t* next; /* with excess preflow.		*/
+  int h;    /* height.			*/
+  flow_t e; /* excess flow.			*/
+  int cur;  /* current arc.			*/
 };
 
-struct edge_t {
-  node_t* u; /* one of the two nodes.	*/
-  node_t* v; /* the other. 			*/
-  int f;     /* flow > 0 if from u to v.	*/
-  int c;     /* capacity.			*/
+/* each undirected edge becomes two arcs, one in the adjacency
+ * of each endpoint. the arcs of node u are arc[off[u]] up to
+ * but not including arc[off[u + 1]].
+ *
+ */
+
+struct arc_t {
+  int v;    /* node the arc points to.	*/
+  flow_t r; /* residual capacity.		*/
+  int rev;  /* index of the reverse arc.	*/
 };
 
 struct graph_t {
   int thr;
-  int fin;
-  int n;     /* nodes.			*/
-  int m;     /* edges.			*/
-  node_t* v; /* array of n nodes.		*/
-  edge_t* e; /* array of m edges.		*/
-  node_t* s; /* source.			*/
-  node_t* t; /* sink.			*/
-  node_t** active;
-  action_t** action;
+  int n;      /* nodes.			*/
+  int m;      /* edges.			*/
+  node_t* v;  /* array of n nodes.		*/
+  int* off;   /* n + 1 arc offsets.		*/
+  arc_t* arc; /* array of 2m arcs.		*/
+  int* home;  /* thread that owns each node.	*/
+  long cut;   /* edges between two owners.	*/
+  node_t* s;  /* source.			*/
+  node_t* t;  /* sink.			*/
+  deque_t* active;     /* one per thread.		*/
+  actions_t* action;   /* thr * thr, from i to j at i * thr + j. */
+  work_args* args;     /* of every thread.		*/
+  int round;           /* statistics kept by thread 0.	*/
+  long total;
+  long stolen;
+  double imbalance;
+  double build; /* seconds to lay out the arcs.	*/
+  double part;  /* seconds to partition.		*/
+  double init;  /* seconds of the initial push.	*/
+  counters_t k; /* of all threads.		*/
+
+  /* workers 0 up to workers - 1 run the current round and the
+   * others are parked. thread 0 plans the next round as the round
+   * number in the high half of plan and the workers in the low.
+   * parked workers with index below joiners join round join.
+   *
+   */
+
+  int workers;
+  atomic_long plan;
+  long busy;       /* sum of workers over rounds.	*/
+  double cost;     /* seconds to discharge a node.	*/
+  pthread_mutex_t park;
+  pthread_cond_t wake;
+  int join;
+  int joiners;
+  int done;
 };
 
+static int verbose; /* print statistics every round.	*/
+static int fixed;   /* always use every worker.		*/
+static int cyclic;  /* node u owned by u % threads.	*/
+static int async;   /* no rounds, see async_preflow.	*/
+static int policy = BARRIER_HYBRID; /* how to wait at barriers. */
+
 static char* progname;
 
 #if PRINT
@@ -104,15 +193,6 @@ void error(const char* fmt, ...) {
   exit(1);
 }
 
-static int next_int() {
-  int x;
-  int c;
-  x = 0;
-  while (isdigit(c = getchar())) x = 10 * x + c - '0';
-
-  return x;
-}
-
 static void* xmalloc(size_t s) {
   void* p;
   p = malloc(s);
@@ -122,6 +202,14 @@ static void* xmalloc(size_t s) {
   return p;
 }
 
+static double now() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
 static void* xcalloc(size_t n, size_t s) {
   void* p;
   p = xmalloc(n * s);
@@ -129,296 +217,1208 @@ static void* xcalloc(size_t n, size_t s) {
   return p;
 }
 
-static void add_edge(node_t* u, edge_t* e) {
-  list_t* p;
-  p = xmalloc(sizeof(list_t));
-  p->edge = e;
-  p->next = u->edge;
-  u->edge = p;
-}
+struct edges_t {
+  const int* x; /* edges as read.		*/
+  arc_t* arc;   /* where to lay them out.	*/
+  int directed; /* no capacity back.		*/
+};
+
+static void fill(void* arg, int i, int j, int k) {
+  edges_t* p = arg;
+  const int* x;
 
-static void connect(node_t* u, node_t* v, int c, edge_t* e) {
-  /* connect two nodes by putting a shared (same object)
-   * in their adjacency lists.
+  /* the arc of edge i out of its first node goes in slot j and
+   * the one out of its second node in slot k.
    *
    */
 
-  e->u = u;
-  e->v = v;
-  e->c = c;
-
-  add_edge(u, e);
-  add_edge(v, e);
+  x = p->x + 3 * i;
+  p->arc[j].v = x[1];
+  p->arc[j].r = x[2];
+  p->arc[j].rev = k;
+  p->arc[k].v = x[0];
+  p->arc[k].r = p->directed ? 0 : x[2];
+  p->arc[k].rev = j;
 }
 
-static graph_t* new_graph(FILE* in, int n, int m, int nthreads) {
+static graph_t* new_graph(graphfile_t* gf, int nthreads) {
+  edges_t edges;
   graph_t* g;
-  node_t* u;
-  node_t* v;
+  arc_t* arc;
+  int* off;
+  int n;
+  int m;
   int i;
-  int a;
-  int b;
-  int c;
 
-  g = xmalloc(sizeof(graph_t));
+  n = gf->n;
+  m = gf->m;
+
+  /* aligned for the counters in it. */
+
+  g = aligned_alloc(64, sizeof(graph_t));
+
+  if (g == NULL) error("out of memory: aligned_alloc failed");
 
   g->n = n;
   g->m = m;
   g->thr = nthreads;
-  g->fin = 0;
+  memset(&g->k, 0, sizeof g->k);
 
   g->v = xcalloc(n, sizeof(node_t));
-  g->e = xcalloc(m, sizeof(edge_t));
+  g->off = off = xcalloc(n + 1, sizeof(int));
+  g->arc = arc = xmalloc(2 * (size_t)m * sizeof(arc_t));
 
   g->s = &g->v[0];
   g->t = &g->v[n - 1];
-  g->action = xcalloc(nthreads, sizeof(action_t*));
-  g->active = xcalloc(nthreads, sizeof(node_t*));
-
-  for (i = 0; i < m; i += 1) {
-    a = next_int();
-    b = next_int();
-    c = next_int();
-    u = &g->v[a];
-    v = &g->v[b];
-    connect(u, v, c, g->e + i);
+  g->action = aligned_alloc(64, nthreads * nthreads * sizeof(actions_t));
+  g->active = aligned_alloc(64, nthreads * sizeof(deque_t));
+
+  if (g->active == NULL || g->action == NULL)
+    error("out of memory: aligned_alloc failed");
+
+  for (i = 0; i < nthreads; i += 1) {
+    atomic_init(&g->active[i].top, 0);
+    atomic_init(&g->active[i].bottom, 0);
+    g->active[i].buf = xcalloc(n, sizeof(_Atomic(node_t*)));
+    g->active[i].size = n;
+  }
+
+  for (i = 0; i < nthreads * nthreads; i += 1) {
+    g->action[i].a = NULL;
+    g->action[i].n = 0;
+    g->action[i].size = 0;
+    g->action[i].allocs = 0;
+  }
+
+  /* the arcs are laid out by the same threads as the solver,
+   * or only filled in when the layout was saved in the graph file.
+   *
+   */
+
+  edges.x = gf->x;
+  edges.arc = arc;
+  edges.directed = (gf->flags & GRAPH_DIRECTED) != 0;
+
+  if (gf->at != NULL) {
+    memcpy(off, gf->off, (n + 1) * sizeof(int));
+    g->build = build_from(gf->at, m, nthreads, fill, &edges);
+  } else {
+    g->build = build_csr(gf->x, n, m, nthreads, off, fill, &edges);
   }
 
   return g;
 }
 
-static node_t* other(node_t* u, edge_t* e) {
-  if (u == e->u)
-    return e->v;
-  else
-    return e->u;
+static void partition(graph_t* g) {
+  arc_t* arc;
+  int* order; /* nodes in breadth first order.	*/
+  int* pos;   /* of each node in order.	*/
+  int* off;
+  int* at;    /* new slot of each arc.		*/
+  int size;   /* nodes per thread.		*/
+  int head;
+  int tail;
+  int u;
+  int a;
+  int b;
+  int i;
+
+  /* the owner of a node applies the actions on it and so writes
+   * its excess and height and the arcs out of it. the nodes are
+   * numbered again in breadth first order from s, with a new
+   * search from the first node not yet reached when one ends, and
+   * each thread owns the next n / threads of them. a thread then
+   * owns a connected region, most pushes stay within it, and its
+   * nodes and arcs are contiguous in memory.
+   *
+   */
+
+  g->part = timebase_sec();
+  g->home = xmalloc(g->n * sizeof(int));
+
+  if (cyclic) {
+    for (u = 0; u < g->n; u += 1) g->home[u] = u % g->thr;
+  } else {
+    order = xmalloc(g->n * sizeof(int));
+    pos = xmalloc(g->n * sizeof(int));
+    off = xmalloc((g->n + 1) * sizeof(int));
+    at = xmalloc(2 * (size_t)g->m * sizeof(int));
+    arc = xmalloc(2 * (size_t)g->m * sizeof(arc_t));
+
+    for (u = 0; u < g->n; u += 1) pos[u] = -1;
+
+    for (tail = 0, i = 0; i < g->n; i += 1) {
+      if (pos[i] >= 0) continue;
+
+      pos[i] = tail;
+      order[tail++] = i;
+
+      for (head = tail - 1; head < tail; head += 1) {
+        u = order[head];
+
+        for (a = g->off[u]; a < g->off[u + 1]; a += 1) {
+          if (pos[g->arc[a].v] < 0) {
+            pos[g->arc[a].v] = tail;
+            order[tail++] = g->arc[a].v;
+          }
+        }
+      }
+    }
+
+    /* node i is now order[i] and keeps the order of its arcs. */
+
+    off[0] = 0;
+
+    for (i = 0; i < g->n; i += 1) {
+      u = order[i];
+      off[i + 1] = off[i] + g->off[u + 1] - g->off[u];
+
+      for (a = g->off[u]; a < g->off[u + 1]; a += 1)
+        at[a] = off[i] + a - g->off[u];
+    }
+
+    for (a = 0; a < 2 * g->m; a += 1) {
+      b = at[a];
+      arc[b].v = pos[g->arc[a].v];
+      arc[b].r = g->arc[a].r;
+      arc[b].rev = at[g->arc[a].rev];
+    }
+
+    g->s = &g->v[pos[g->s - g->v]];
+    g->t = &g->v[pos[g->t - g->v]];
+
+    free(g->off);
+    free(g->arc);
+    g->off = off;
+    g->arc = arc;
+
+    size = (g->n + g->thr - 1) / g->thr;
+
+    for (u = 0; u < g->n; u += 1) g->home[u] = u / size;
+
+    free(order);
+    free(pos);
+    free(at);
+  }
+
+  g->cut = 0;
+
+  for (u = 0; u < g->n; u += 1)
+    for (a = g->off[u]; a < g->off[u + 1]; a += 1)
+      if (g->home[u] != g->home[g->arc[a].v]) g->cut += 1;
+
+  g->cut /= 2;
+  g->part = timebase_sec() - g->part;
 }
 
-static int direction(node_t* u, edge_t* e) { return (u == e->u) ? 1 : -1; }
+static int reaches(graph_t* g, node_t* u, arc_t* arc) {
+  return arc->r > 0 || (g->arc[arc->rev].r > 0 && g->v[arc->v].h > u->h);
+}
 
-static int available(edge_t* e, int dir) { return e->c - dir * e->f; }
+static void push_arc(graph_t* g, int i, flow_t flo) {
+  g->arc[i].r -= flo;
+  g->arc[g->arc[i].rev].r += flo;
+}
 
-static void add_active(graph_t* g, node_t* node, int thr) {
-  if (node != g->t && node != g->s) {
-    node->next = g->active[thr];
-    g->active[thr] = node;
+#define EMPTY ((node_t*)0)
+#define ABORT ((node_t*)1)
+
+static void deque_push(deque_t* q, node_t* u) {
+  long b;
+
+  b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+  atomic_store_explicit(&q->buf[b % q->size], u, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+}
+
+static node_t* deque_take(deque_t* q) {
+  node_t* u;
+  long b;
+  long t;
+
+  b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  t = atomic_load_explicit(&q->top, memory_order_relaxed);
+
+  if (t > b) {
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    return EMPTY;
+  }
+
+  u = atomic_load_explicit(&q->buf[b % q->size], memory_order_relaxed);
+
+  if (t == b) {
+    /* last one, race against the thieves for it. */
+
+    if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed))
+      u = EMPTY;
+
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
   }
+
+  return u;
 }
 
-static node_t* pop_active(graph_t* g, int thr) {
+static node_t* deque_steal(deque_t* q, counters_t* k) {
+  node_t* u;
+  long b;
+  long t;
+
+  t = atomic_load_explicit(&q->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+
+  if (t >= b) return EMPTY;
+
+  u = atomic_load_explicit(&q->buf[t % q->size], memory_order_relaxed);
+
+  if (!atomic_compare_exchange_strong_explicit(
+          &q->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+    count(k, C_CAS);
+    return ABORT;
+  }
+
+  return u;
+}
+
+static int owner(graph_t* g, node_t* u) { return g->home[u - g->v]; }
+
+static void add_active(graph_t* g, node_t* node, int thr) {
+  if (node != g->t && node != g->s) deque_push(&g->active[thr], node);
+}
+
+static node_t* pop_active(graph_t* g, work_args* args) {
   node_t* a;
-  a = g->active[thr];
-  if (a != NULL) g->active[thr] = a->next;
+  int i;
+  int k;
+
+  a = deque_take(&g->active[args->i]);
+
+  /* nothing new becomes active during a round so when every
+   * deque looks empty the round is over for this worker.
+   *
+   */
+
+  for (k = 1; a == EMPTY && k < g->thr; k += 1) {
+    i = (args->i + k) % g->thr;
+
+    while ((a = deque_steal(&g->active[i], &args->k)) == ABORT)
+      ;
+
+    if (a != EMPTY) {
+      args->steals += 1;
+      count(&args->k, C_STEAL);
+    }
+  }
+
+  if (a != EMPTY) {
+    args->nodes += 1;
+    count(&args->k, C_DISCHARGE);
+  }
+
   return a;
 }
 
-static void queue_action(graph_t* g, action_t* action, int thr) {
-  action->next = g->action[thr];
-  g->action[thr] = action;
+static void queue_action(graph_t* g, int thr, node_t* node, int arc,
+                         flow_t flo) {
+  actions_t* q;
+  action_t* a;
+
+  q = &g->action[thr * g->thr + owner(g, node)];
+
+  if (q->n == q->size) {
+    q->size = q->size == 0 ? 1024 : 2 * q->size;
+    q->a = realloc(q->a, q->size * sizeof(action_t));
+    q->allocs += 1;
+
+    if (q->a == NULL) error("out of memory: realloc failed");
+  }
+
+  a = &q->a[q->n++];
+  a->node = node - g->v;
+  a->arc = arc;
+  a->flo = flo;
 }
 
-static action_t* pop_action(graph_t* g, int thr) {
-  action_t* a;
-  a = g->action[thr];
-  if (a != NULL) g->action[thr] = a->next;
-  return a;
+static int plan(graph_t* g, int nodes) {
+  double busy;
+  long queued;
+  int next;
+  int i;
+
+  /* every action queued this round can make at most one node
+   * active in the next, so that bounds the work to share. the
+   * cost per node is the time the workers spent discharging,
+   * without the barriers, smoothed over the recent rounds.
+   *
+   */
+
+  for (busy = 0, queued = 0, i = 0; i < g->workers; i += 1) {
+    busy += g->args[i].busy;
+    queued += g->args[i].queued;
+  }
+
+  if (nodes > 0)
+    g->cost = g->cost == 0 ? busy / nodes
+                           : 0.75 * g->cost + 0.25 * busy / nodes;
+
+  if (fixed) return g->thr;
+
+  next = queued * g->cost / SLICE;
+
+  return MAX(1, MIN(g->thr, next));
+}
+
+static void round_stats(graph_t* g) {
+  work_args* args;
+  int nodes;
+  int steals;
+  int most;
+  int next;
+  int i;
+
+  /* load balance of the round that just ended, as the most
+   * nodes any worker discharged over the mean.
+   *
+   */
+
+  args = g->args;
+  nodes = steals = most = 0;
+
+  for (i = 0; i < g->thr; i += 1) {
+    nodes += args[i].nodes;
+    steals += args[i].steals;
+    most = args[i].nodes > most ? args[i].nodes : most;
+    args[i].nodes = args[i].steals = 0;
+  }
+
+  g->round += 1;
+  count(&args[0].k, C_ROUND);
+  g->total += nodes;
+  g->stolen += steals;
+  g->busy += g->workers;
+
+  if (nodes > 0) g->imbalance += (double)most * g->workers / nodes;
+
+  if (verbose)
+    fprintf(stderr,
+            "round %d: workers = %d, nodes = %d, steals = %d, "
+            "max/mean = %.2f\n",
+            g->round, g->workers, nodes, steals,
+            nodes > 0 ? (double)most * g->workers / nodes : 0.0);
+
+  /* no worker can arrive at the first barrier again before all
+   * have passed the second, so it can be resized now.
+   *
+   */
+
+  next = plan(g, nodes);
+  barrier_resize(g->args[0].bar1, next);
+  atomic_store(&g->plan, (long)(g->round + 1) << 32 | next);
+}
+
+static void wake(graph_t* g) {
+  int next;
+
+  /* thread 0 after the second barrier. the others cannot reach
+   * it again before thread 0 has passed the first.
+   *
+   */
+
+  next = atomic_load(&g->plan) & 0xffffffff;
+  barrier_resize(g->args[0].bar2, next);
+
+  if (next > g->workers) {
+    pthread_mutex_lock(&g->park);
+    g->join = g->round + 1;
+    g->joiners = next;
+    pthread_cond_broadcast(&g->wake);
+    pthread_mutex_unlock(&g->park);
+  }
+
+  g->workers = next;
+}
+
+static int park(graph_t* g, work_args* args, int* round) {
+  long p;
+  int joined;
+
+  /* a worker that is in the plan for the next round is waited
+   * for, so the plan cannot change before it has read it. one
+   * that is not may see a later plan, but only once that round
+   * has started without it.
+   *
+   */
+
+  p = atomic_load(&g->plan);
+
+  if (p >> 32 == *round + 1 && args->i < (p & 0xffffffff)) return 1;
+
+  args->parks += 1;
+
+  pthread_mutex_lock(&g->park);
+
+  while (!g->done && !(g->join > *round && args->i < g->joiners))
+    pthread_cond_wait(&g->wake, &g->park);
+
+  joined = !g->done;
+
+  if (joined) *round = g->join - 1;
+
+  pthread_mutex_unlock(&g->park);
+
+  return joined;
+}
+
+static void apply_owner(graph_t* g, work_args* args, int j) {
+  actions_t* q;
+  action_t* action;
+  action_t* end;
+  node_t* u;
+  int i;
+
+  for (i = 0; i < g->thr; i += 1) {
+    q = &g->action[i * g->thr + j];
+    action = q->a;
+    end = action + q->n;
+    args->actions += q->n;
+
+    if (i != args->i) args->cross += q->n;
+
+    for (; action < end; action += 1) {
+      u = &g->v[action->node];
+
+      if (action->arc < 0) {
+        u->h = -1 - action->arc;
+        u->cur = g->off[action->node];
+        add_active(g, u, args->i);
+      } else {
+        u->e += action->flo;
+        push_arc(g, action->arc, action->flo);
+
+        if (u->e == action->flo) {
+          add_active(g, u, args->i);
+        }
+      }
+    }
+
+    q->n = 0;
+  }
+}
+
+static int apply(graph_t* g, work_args* args) {
+  deque_t* d;
+  int j;
+
+  /* every action is for a node owned by this thread, or by a
+   * parked one it stands in for, and no two actions of a round
+   * touch the same arc, so the workers can apply their actions
+   * at the same time.
+   *
+   */
+
+  d = &g->active[args->i];
+  atomic_store(&d->top, 0);
+  atomic_store(&d->bottom, 0);
+
+  for (j = args->i; j < g->thr; j += g->workers)
+    apply_owner(g, args, j);
+
+  return atomic_load(&d->bottom);
 }
 
 static void* work(void* arg) {
   node_t* nei;
-  edge_t* edg;
-  list_t* adj;
-  action_t* action;
+  arc_t* arc;
   node_t* active;
 
-  int dir;
-  int ava;
-  int flo;
+  int u;
+  int i;
+  int start;
+  int end;
+  int min;
+  flow_t ava;
+  flow_t flo;
+  int round;
+  double begin;
 
   work_args* args = (work_args*)arg;
   graph_t* g = args->g;
 
-  while (!g->fin) {
-    active = pop_active(g, args->i);
+  for (round = 0;;) {
+    begin = now();
+    active = pop_active(g, args);
 
     while (active != NULL) {
-      adj = active->edge;
-
-      while (adj != NULL && active->e > 0) {
-        edg = adj->edge;
-        adj = adj->next;
-
-        // Get direction and other node
-        nei = other(active, edg);
-        dir = direction(active, edg);
-        ava = available(edg, dir);
+      u = active - g->v;
+      start = active->cur;
+      end = g->off[u + 1];
+      min = INT_MAX;
+
+      /* push along the arcs from the current one on. an arc before
+       * it cannot become admissible until the node gets a new
+       * height: heights only grow and a push back over it needs
+       * the neighbour above the node. min is the lowest neighbour
+       * that the node could have an arc to after this round, which
+       * is one with residual capacity now or one above the node
+       * that may push back to it in this round.
+       *
+       */
+
+      for (i = start; i < end && active->e > 0; i += 1) {
+        arc = &g->arc[i];
+        nei = &g->v[arc->v];
+        ava = arc->r;
+        count(&args->k, C_SCAN);
 
         // Can push to neighbour, queue a push
         if (active->h > nei->h && ava > 0) {
           flo = MIN(active->e, ava);
           active->e -= flo;
+          count(&args->k, C_PUSH);
+
+          if (flo == ava) count(&args->k, C_SATURATE);
 
-          // Allocate and init a new action
-          action = xmalloc(sizeof(action_t));
-          action->dir = dir;
-          action->flo = flo;
-          action->edge = edg;
-          action->node = nei;
-          action->relabel = 0;
-          queue_action(g, action, args->i);
+          queue_action(g, args->i, nei, i, flo);
+
+          /* stay on an arc that is not saturated. */
+
+          if (flo < ava) i -= 1;
+        } else if (nei->h < min && reaches(g, active, arc)) {
+          min = nei->h;
         }
       }
 
-      // All edges checked, relabel if excess > 0
+      active->cur = i;
+
+      // All arcs from the current one checked, relabel if excess > 0
       if (active->e > 0) {
-        action = xmalloc(sizeof(action_t));
-        action->relabel = 1;
-        action->node = active;
-        queue_action(g, action, args->i);
+        for (i = g->off[u]; i < start; i += 1) {
+          arc = &g->arc[i];
+          nei = &g->v[arc->v];
+          count(&args->k, C_SCAN);
+
+          if (nei->h < min && reaches(g, active, arc)) min = nei->h;
+        }
+
+        queue_action(g, args->i, active, -2 - min, 0);
+        count(&args->k, C_RELABEL);
       }
 
-      active = pop_active(g, args->i);
+      active = pop_active(g, args);
     }
 
-    pthread_barrier_wait(args->bar1);
-    pthread_barrier_wait(args->bar2);
+    args->busy = now() - begin;
+    args->queued = 0;
+
+    for (i = 0; i < g->thr; i += 1)
+      args->queued += g->action[args->i * g->thr + i].n;
+
+    barrier_wait(args->bar1);
+
+    if (args->i == 0) round_stats(g);
+
+    /* the apply phase writes heights and residual capacities
+     * that the next round reads from any thread, so both barriers
+     * are needed, but the second also sums the new active nodes
+     * of all threads to decide whether to stop. a worker that is
+     * to be parked may see the sum of a later round, but that is
+     * only zero if the later round was the last one.
+     *
+     */
+
+    if (barrier_sum(args->bar2, apply(g, args)) == 0) break;
+
+    round += 1;
+
+    if (args->i == 0)
+      wake(g);
+    else if (!park(g, args, &round))
+      break;
+  }
+
+  if (args->i == 0) {
+    pthread_mutex_lock(&g->park);
+    g->done = 1;
+    pthread_cond_broadcast(&g->wake);
+    pthread_mutex_unlock(&g->park);
   }
 
   return 0;
 }
 
-static int preflow(graph_t* g) {
+static flow_t preflow(graph_t* g) {
   node_t* src;
   node_t* nei;
-  edge_t* edg;
-  list_t* adj;
-  int dir;
-  int i = 0;
-  int d = 0;
+  flow_t flo;
+  int a;
+  int i;
+  long actions = 0;
+  long cross = 0;
+  long allocs = 0;
+  long parks = 0;
+
+  g->init = timebase_sec();
 
   src = g->s;
   src->h = g->n;
 
-  adj = src->edge;
+  for (i = 0; i < g->n; i += 1) g->v[i].cur = g->off[i];
 
   // Initial push from source
-  while (adj != NULL) {
-    edg = adj->edge;
-    adj = adj->next;
-    nei = other(src, edg);
-    dir = direction(src, edg);
-    edg->f += dir * edg->c;
-    nei->e += edg->c;
-
-    add_active(g, nei, i);
-
-    if (i == g->thr - 1)
-      i = 0;
-    else
-      i += 1;
+  for (a = g->off[src - g->v]; a < g->off[src - g->v + 1]; a += 1) {
+    nei = &g->v[g->arc[a].v];
+    flo = g->arc[a].r;
+    push_arc(g, a, flo);
+    nei->e += flo;
+
+    /* parallel edges from the source must not put the
+     * same node twice in an active list.
+     */
+
+    if (flo > 0 && nei->e == flo) add_active(g, nei, owner(g, nei));
   }
 
-  pthread_barrier_t barr[2];
-  pthread_barrier_init(&barr[0], NULL, g->thr + 1);
-  pthread_barrier_init(&barr[1], NULL, g->thr + 1);
+  g->init = timebase_sec() - g->init;
+
+  barrier_t barr[2];
+  barrier_init(&barr[0], g->thr, policy);
+  barrier_init(&barr[1], g->thr, policy);
 
   pthread_t thread[g->thr];
   work_args args[g->thr];
 
+  g->args = args;
+  g->round = 0;
+  g->total = 0;
+  g->stolen = 0;
+  g->imbalance = 0;
+  g->workers = g->thr;
+  atomic_init(&g->plan, 0);
+  g->busy = 0;
+  g->cost = 0;
+  g->join = 0;
+  g->joiners = 0;
+  g->done = 0;
+  pthread_mutex_init(&g->park, NULL);
+  pthread_cond_init(&g->wake, NULL);
+
   for (i = 0; i < g->thr; i += 1) {
     args[i].bar1 = &barr[0];
     args[i].bar2 = &barr[1];
     args[i].g = g;
     args[i].i = i;
+    args[i].nodes = 0;
+    args[i].steals = 0;
+    args[i].actions = 0;
+    args[i].cross = 0;
+    args[i].queued = 0;
+    args[i].busy = 0;
+    args[i].parks = 0;
+    memset(&args[i].k, 0, sizeof args[i].k);
+  }
 
+  for (i = 0; i < g->thr; i += 1)
     if (pthread_create(&thread[i], NULL, work, &args[i]) != 0)
       error("pthread_create failed");
+
+  for (i = 0; i < g->thr; i += 1)
+    if (pthread_join(thread[i], NULL) != 0) error("pthread_join failed");
+
+  barrier_destroy(&barr[0]);
+  barrier_destroy(&barr[1]);
+  pthread_mutex_destroy(&g->park);
+  pthread_cond_destroy(&g->wake);
+
+  fprintf(stderr, "rounds = %d, nodes = %ld, steals = %ld, max/mean = %.2f\n",
+          g->round, g->total, g->stolen,
+          g->round > 0 ? g->imbalance / g->round : 0.0);
+
+  for (i = 0; i < g->thr; i += 1) {
+    actions += args[i].actions;
+    cross += args[i].cross;
   }
 
-  while (!g->fin) {
-    d = 0;
-    pthread_barrier_wait(&barr[0]);
+  for (i = 0; i < g->thr * g->thr; i += 1) allocs += g->action[i].allocs;
 
-    for (i = 0; i < g->thr; i += 1) {
-      action_t* action = pop_action(g, i);
+  fprintf(stderr,
+          "actions = %ld (%.1f%% across threads), action allocations = %ld\n",
+          actions, actions > 0 ? 100.0 * cross / actions : 0.0, allocs);
 
-      while (action != NULL) {
-        if (action->relabel) {
-          action->node->h += 1;
-          add_active(g, action->node, i);
-        } else {
-          action->node->e += action->flo;
-          action->edge->f += action->flo * action->dir;
+  for (i = 0; i < g->thr; i += 1) {
+    parks += args[i].parks;
+    counters_add(&g->k, &args[i].k);
+  }
 
-          if (action->node->e == action->flo) {
-            add_active(g, action->node, i);
-          }
-        }
+  fprintf(stderr, "workers = %.2f per round (%s, at most %d), parks = %ld\n",
+          g->round > 0 ? (double)g->busy / g->round : 0.0,
+          fixed ? "fixed" : "adaptive", g->thr, parks);
+
+  return g->t->e;
+}
+
+/* the asynchronous engine of -a has no rounds and no barriers.
+ * each thread discharges only the nodes it owns and is the only
+ * one to write their excess, height and the residual capacity of
+ * the arcs out of them. a push to a node of another thread takes
+ * the flow off the arc and the excess at once, and sends the arc
+ * and the amount in a message to the owner, which adds them to
+ * the reverse arc and the excess of the node when it drains its
+ * rings between discharges. a thread thus always sees every arc
+ * back to where its excess came from.
+ *
+ * heights of other threads' nodes are read while their owners
+ * change them, and like in the lab2 lock-free engine a push goes
+ * to the lowest neighbour with residual capacity if u is above
+ * it, and otherwise u is lifted to just above that neighbour.
+ *
+ */
+
+#define RING 1024 /* messages in a ring, a power of two.	*/
+
+typedef struct message_t message_t;
+typedef struct ring_t ring_t;
+typedef struct async_t async_t;
+typedef struct async_args async_args;
+
+struct message_t {
+  int arc;  /* pushed over, out of a node of the sender. */
+  flow_t d; /* amount.				*/
+};
+
+/* a single producer single consumer ring. only the sender writes
+ * tail and only the receiver head, and each publishes with a
+ * release store what the other reads with an acquire load.
+ *
+ */
+
+struct ring_t {
+  _Alignas(64) atomic_long head; /* next to receive.		*/
+  _Alignas(64) atomic_long tail; /* next to send.		*/
+  message_t buf[RING];
+};
+
+/* termination is detected as by Safra. each thread counts the
+ * messages it sent minus those it received, and turns black when
+ * it receives one. a token goes around the threads from thread 0
+ * down to 1 and is passed on only by a thread with no active nodes,
+ * which adds its count, blackens the token if it is black itself
+ * and turns white. when the token comes back white to a white
+ * thread 0 with no active nodes and the counts sum to zero, no
+ * message is in flight and no thread can become active again.
+ *
+ */
+
+struct async_t {
+  graph_t* g;
+  int thr;
+  atomic_int* h;        /* height of each node.		*/
+  ring_t* ring;         /* thr * thr, from i to j at i * thr + j. */
+  int** stack;          /* active nodes of each thread.	*/
+  int* size;            /* on each stack.		*/
+  _Alignas(64) atomic_int token; /* thread that holds it.	*/
+  long q;               /* sum of counts so far.	*/
+  int black;            /* of the token.			*/
+  atomic_int done;
+};
+
+struct async_args {
+  async_t* as;
+  int i;        /* thread index.			*/
+  long c;       /* messages sent minus received.	*/
+  int black;    /* received since the token left.	*/
+  long sent;    /* messages in total.		*/
+  long full;    /* times a ring was full.		*/
+  int waves;    /* tokens sent around, thread 0.	*/
+  counters_t k; /* with -DCOUNT=1.		*/
+};
+
+static void async_activate(async_t* as, int u, int thr) {
+  if (u != as->g->s - as->g->v && u != as->g->t - as->g->v)
+    as->stack[thr][as->size[thr]++] = u;
+}
+
+static int async_drain(async_args* args) {
+  async_t* as;
+  graph_t* g;
+  ring_t* ring;
+  message_t* m;
+  long first;
+  long head;
+  long tail;
+  int got;
+  int v;
+  int j;
+
+  /* apply every message sent to this thread. */
+
+  as = args->as;
+  g = as->g;
+  got = 0;
+
+  for (j = 0; j < as->thr; j += 1) {
+    ring = &as->ring[j * as->thr + args->i];
+    first = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    for (head = first; head < tail; head += 1) {
+      m = &ring->buf[head & (RING - 1)];
+      v = g->arc[m->arc].v;
+      g->arc[g->arc[m->arc].rev].r += m->d;
+      g->v[v].e += m->d;
+
+      if (g->v[v].e == m->d) async_activate(as, v, args->i);
+    }
+
+    got += tail - first;
+    atomic_store_explicit(&ring->head, tail, memory_order_release);
+  }
 
-        free(action);
-        action = pop_action(g, i);
+  if (got > 0) {
+    args->c -= got;
+    args->black = 1;
+  }
+
+  return got;
+}
+
+static void async_send(async_args* args, int j, int a, flow_t d) {
+  ring_t* ring;
+  long tail;
+
+  ring = &args->as->ring[args->i * args->as->thr + j];
+  tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+  /* while the ring is full, receive instead. receiving never
+   * sends, so two threads cannot wait for each other.
+   *
+   */
+
+  if (tail - atomic_load_explicit(&ring->head, memory_order_acquire) == RING) {
+    args->full += 1;
+
+    while (tail - atomic_load_explicit(&ring->head, memory_order_acquire) ==
+           RING)
+      if (async_drain(args) == 0) sched_yield();
+  }
+
+  ring->buf[tail & (RING - 1)].arc = a;
+  ring->buf[tail & (RING - 1)].d = d;
+  atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+  args->c += 1;
+  args->sent += 1;
+}
+
+static void async_discharge(async_args* args, int u) {
+  async_t* as;
+  graph_t* g;
+  arc_t* arc;
+  flow_t d;
+  int low; /* arc to the lowest neighbour.	*/
+  int min;
+  int end;
+  int h;
+  int a;
+  int v;
+
+  as = args->as;
+  g = as->g;
+  end = g->off[u + 1];
+  count(&args->k, C_DISCHARGE);
+
+  while (g->v[u].e > 0) {
+    min = INT_MAX;
+    low = -1;
+
+    for (a = g->off[u]; a < end; a += 1) {
+      count(&args->k, C_SCAN);
+
+      if (g->arc[a].r <= 0) continue;
+
+      h = atomic_load_explicit(&as->h[g->arc[a].v], memory_order_relaxed);
+
+      if (h < min) {
+        min = h;
+        low = a;
       }
+    }
 
-      if (g->active[i] == NULL) d += 1;
+    if (atomic_load_explicit(&as->h[u], memory_order_relaxed) <= min) {
+      atomic_store_explicit(&as->h[u], min + 1, memory_order_relaxed);
+      count(&args->k, C_RELABEL);
+      continue;
     }
 
-    if (d == g->thr) g->fin = 1;
+    arc = &g->arc[low];
+    v = arc->v;
+    d = MIN(g->v[u].e, arc->r);
+    arc->r -= d;
+    g->v[u].e -= d;
+    count(&args->k, C_PUSH);
 
-    pthread_barrier_wait(&barr[1]);
+    if (arc->r == 0) count(&args->k, C_SATURATE);
+
+    if (g->home[v] == args->i) {
+      g->arc[arc->rev].r += d;
+      g->v[v].e += d;
+
+      if (g->v[v].e == d) async_activate(as, v, args->i);
+    } else {
+      async_send(args, g->home[v], low, d);
+    }
   }
+}
 
-  for (i = 0; i < g->thr; i += 1)
+static void async_token(async_args* args) {
+  async_t* as;
+  int next;
+
+  /* called with no active nodes by the thread holding the token. */
+
+  as = args->as;
+
+  if (args->i == 0) {
+    if (args->waves > 0 && !as->black && !args->black && as->q + args->c == 0) {
+      atomic_store(&as->done, 1);
+      return;
+    }
+
+    as->q = 0;
+    as->black = 0;
+    args->waves += 1;
+  } else {
+    as->q += args->c;
+    as->black |= args->black;
+  }
+
+  args->black = 0;
+  next = (args->i + as->thr - 1) % as->thr;
+  atomic_store_explicit(&as->token, next, memory_order_release);
+}
+
+static void* async_work(void* arg) {
+  async_args* args;
+  async_t* as;
+  int i;
+
+  args = arg;
+  as = args->as;
+  i = args->i;
+
+  while (!atomic_load(&as->done)) {
+    async_drain(args);
+
+    if (as->size[i] > 0) {
+      async_discharge(args, as->stack[i][--as->size[i]]);
+      continue;
+    }
+
+    if (atomic_load_explicit(&as->token, memory_order_acquire) == i)
+      async_token(args);
+    else
+      sched_yield();
+  }
+
+  return 0;
+}
+
+static flow_t async_preflow(graph_t* g) {
+  async_t as;
+  async_args args[g->thr];
+  pthread_t thread[g->thr];
+  long sent;
+  long full;
+  int s;
+  int a;
+  int v;
+  int i;
+
+  g->init = timebase_sec();
+
+  as.g = g;
+  as.thr = g->thr;
+  as.h = xcalloc(g->n, sizeof(atomic_int));
+  as.ring = aligned_alloc(64, g->thr * g->thr * sizeof(ring_t));
+  as.stack = xmalloc(g->thr * sizeof(int*));
+  as.size = xcalloc(g->thr, sizeof(int));
+  as.q = 0;
+  as.black = 0;
+  atomic_init(&as.token, 0);
+  atomic_init(&as.done, 0);
+
+  if (as.ring == NULL) error("out of memory: aligned_alloc failed");
+
+  for (i = 0; i < g->thr * g->thr; i += 1) {
+    atomic_init(&as.ring[i].head, 0);
+    atomic_init(&as.ring[i].tail, 0);
+  }
+
+  /* a node is on the stack of its owner at most once. */
+
+  for (i = 0; i < g->thr; i += 1) as.stack[i] = xmalloc(g->n * sizeof(int));
+
+  s = g->s - g->v;
+  atomic_store(&as.h[s], g->n);
+
+  // Initial push from source, before any thread runs
+  for (a = g->off[s]; a < g->off[s + 1]; a += 1) {
+    v = g->arc[a].v;
+
+    if (g->arc[a].r == 0 || v == s) continue;
+
+    g->v[v].e += g->arc[a].r;
+    g->arc[g->arc[a].rev].r += g->arc[a].r;
+
+    if (g->v[v].e == g->arc[a].r) async_activate(&as, v, g->home[v]);
+
+    g->arc[a].r = 0;
+  }
+
+  g->init = timebase_sec() - g->init;
+
+  for (i = 0; i < g->thr; i += 1) {
+    args[i].as = &as;
+    args[i].i = i;
+    args[i].c = 0;
+    args[i].black = 0;
+    args[i].sent = 0;
+    args[i].full = 0;
+    args[i].waves = 0;
+    memset(&args[i].k, 0, sizeof args[i].k);
+    if (pthread_create(&thread[i], NULL, async_work, &args[i]) != 0)
+      error("pthread_create failed");
+  }
+
+  sent = full = 0;
+
+  for (i = 0; i < g->thr; i += 1) {
     if (pthread_join(thread[i], NULL) != 0) error("pthread_join failed");
+    sent += args[i].sent;
+    full += args[i].full;
+    counters_add(&g->k, &args[i].k);
+  }
+
+  fprintf(stderr, "messages = %ld, full rings = %ld, waves = %d\n", sent, full,
+          args[0].waves);
+
+  for (i = 0; i < g->thr; i += 1) free(as.stack[i]);
+
+  free(as.h);
+  free(as.ring);
+  free(as.stack);
+  free(as.size);
 
   return g->t->e;
 }
 
 static void free_graph(graph_t* g) {
   int i;
-  list_t* p;
-  list_t* q;
-
-  for (i = 0; i < g->n; i += 1) {
-    p = g->v[i].edge;
-    while (p != NULL) {
-      q = p->next;
-      free(p);
-      p = q;
-    }
-  }
+
+  for (i = 0; i < g->thr; i += 1) free(g->active[i].buf);
+
+  for (i = 0; i < g->thr * g->thr; i += 1) free(g->action[i].a);
 
   free(g->v);
-  free(g->e);
+  free(g->off);
+  free(g->arc);
+  free(g->home);
+  free(g->action);
+  free(g->active);
   free(g);
 }
 
 int main(int argc, char* argv[]) {
-  FILE* in;   /* input file set to stdin	*/
-  graph_t* g; /* undirected graph. 		*/
-  int f;      /* output from preflow.		*/
-  int n;      /* number of nodes.		*/
-  int m;      /* number of edges.		*/
+  input_t in;     /* all of stdin.			*/
+  graphfile_t gf; /* text or binary graph in it.	*/
+  graph_t* g;     /* undirected graph. 		*/
+  flow_t f;       /* output from preflow.		*/
+  int c;          /* command line option.		*/
+  int nthread = 2;
+  double begin;   /* of the current phase.		*/
+  double teardown; /* freeing everything.		*/
 
   progname = argv[0]; /* name is a string in argv[0]. */
 
-  in = stdin; /* same as System.in in Java.	*/
-
-  n = next_int();
-  m = next_int();
-
-  /* skip C and P from the 6railwayplanning lab in EDAF05 */
-  next_int();
-  next_int();
-
-  g = new_graph(in, n, m, 2);
-
-  fclose(in);
+  while ((c = getopt(argc, argv, "ab:fp:t:v")) != -1) {
+    switch (c) {
+      case 'a':
+        /* rings between threads instead of rounds. */
+        async = 1;
+        break;
+      case 'b':
+        /* spin, hybrid or block. */
+        if ((policy = barrier_policy(optarg)) < 0)
+          error("unknown barrier policy %s", optarg);
+        break;
+      case 'f':
+        /* every worker in every round. */
+        fixed = 1;
+        break;
+      case 'p':
+        /* bfs or cyclic. */
+        if (strcmp(optarg, "cyclic") == 0)
+          cyclic = 1;
+        else if (strcmp(optarg, "bfs") != 0)
+          error("unknown partition %s", optarg);
+        break;
+      case 't':
+        nthread = atoi(optarg);
+        break;
+      case 'v':
+        verbose = 1;
+        break;
+      default:
+        error("usage: %s [-a] [-b policy] [-f] [-p bfs|cyclic] [-t threads] "
+              "[-v] < input",
+              progname);
+    }
+  }
 
-  f = preflow(g);
+  if (nthread < 1) error("need at least one thread");
+
+  init_timebase();
+
+  begin = timebase_sec();
+  input_open(&in, stdin);
+  graphfile_load(&gf, &in, nthread);
+  phase_report(stderr, "parse", timebase_sec() - begin);
+  flow_check(&gf);
+
+  begin = timebase_sec();
+  g = new_graph(&gf, nthread);
+  partition(g);
+  phase_report(stderr, "build", timebase_sec() - begin);
+
+  begin = timebase_sec();
+  graphfile_free(&gf);
+  input_close(&in);
+  teardown = timebase_sec() - begin;
+  input_report(&in, stderr);
+  fprintf(stderr, "build = %.3f s (%d threads)\n", g->build, nthread);
+  fprintf(stderr, "partition = %.3f s (%s), cut = %ld edges (%.1f%%)\n",
+          g->part, cyclic ? "cyclic" : "bfs", g->cut,
+          g->m > 0 ? 100.0 * g->cut / g->m : 0.0);
+  flow_report(stderr, g->n * sizeof(node_t) + (g->n + 1) * sizeof(int) +
+                          2 * (size_t)g->m * sizeof(arc_t));
+
+  begin = timebase_sec();
+  if (async)
+    f = async_preflow(g);
+  else
+    f = preflow(g);
+  phase_report(stderr, "init", g->init);
+  phase_report(stderr, "solve", timebase_sec() - begin - g->init);
 
-  printf("f = %d\n", f);
+  printf("f = %" PRIflow "\n", f);
+  counters_report(stdout, &g->k);
 
+  begin = timebase_sec();
   free_graph(g);
+  phase_report(stderr, "teardown", teardown + timebase_sec() - begin);
 
   return 0;
 }